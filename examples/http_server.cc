@@ -159,10 +159,10 @@ class MyHandler : public Http::Handler
         {
             if (req.method() == Http::Method::Get)
             {
-                Http::serveFile(response, "README.md").then([](PST_SSIZE_T bytes) {
+                Http::serveFile(response, req, "README.md").then([](PST_SSIZE_T bytes) {
                     std::cout << "Sent " << bytes << " bytes" << std::endl;
                 },
-                                                            Async::NoExcept);
+                                                                 Async::NoExcept);
             }
         }
         else
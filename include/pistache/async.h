@@ -201,35 +201,191 @@ namespace Pistache::Async
             virtual ~Request()                                      = default;
         };
 
+        /*
+         * Memory for the cores and continuations of the promises, which are
+         * created and destroyed by the million. Every thread keeps up to
+         * MaxBlocks blocks of each size it frees for the next promises it
+         * creates. As with the BufferPool, a block freed by another thread
+         * than the one that allocated it goes to the cache of the former.
+         */
+        template <size_t Size>
+        class BlockCache
+        {
+        public:
+            static constexpr size_t MaxBlocks = 64;
+
+            static void* acquire()
+            {
+                auto* cache = local();
+                if (cache && cache->count_ > 0)
+                    return cache->blocks_[--cache->count_];
+
+                return ::operator new(Size);
+            }
+
+            static void release(void* block)
+            {
+                auto* cache = local();
+                if (cache && cache->count_ < MaxBlocks)
+                    cache->blocks_[cache->count_++] = block;
+                else
+                    ::operator delete(block);
+            }
+
+        private:
+            BlockCache() { alive_ = true; }
+
+            ~BlockCache()
+            {
+                alive_ = false;
+                for (size_t i = 0; i < count_; ++i)
+                    ::operator delete(blocks_[i]);
+            }
+
+            // Blocks freed by a thread that is exiting, after its cache has
+            // been destroyed, are freed right away
+            static BlockCache* local()
+            {
+                static thread_local BlockCache cache;
+                return alive_ ? &cache : nullptr;
+            }
+
+            static thread_local bool alive_;
+
+            void* blocks_[MaxBlocks];
+            size_t count_ = 0;
+        };
+
+        template <size_t Size>
+        thread_local bool BlockCache<Size>::alive_ = false;
+
+        template <typename T>
+        struct PoolAllocator
+        {
+            using value_type = T;
+
+            // Sizes are rounded up so that similar objects share a cache
+            using Cache = BlockCache<(sizeof(T) + 15) / 16 * 16>;
+
+            static constexpr bool Pooled = alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+            PoolAllocator() = default;
+
+            template <typename U>
+            PoolAllocator(const PoolAllocator<U>&) // NOLINT(google-explicit-constructor)
+            { }
+
+            T* allocate(size_t n)
+            {
+                if (Pooled && n == 1)
+                    return static_cast<T*>(Cache::acquire());
+                return std::allocator<T>().allocate(n);
+            }
+
+            void deallocate(T* p, size_t n)
+            {
+                if (Pooled && n == 1)
+                    Cache::release(p);
+                else
+                    std::allocator<T>().deallocate(p, n);
+            }
+
+            template <typename U>
+            bool operator==(const PoolAllocator<U>&) const { return true; }
+
+            template <typename U>
+            bool operator!=(const PoolAllocator<U>&) const { return false; }
+        };
+
+        // std::make_shared(), with the memory taken from the pool
+        template <typename T, typename... Args>
+        std::shared_ptr<T> makeShared(Args&&... args)
+        {
+            return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+        }
+
         struct Core
         {
             Core(State _state, TypeId _id)
                 : allocated(false)
                 , state(_state)
                 , exc()
-                , mtx()
-                , requests()
                 , id(_id)
             { }
 
             bool allocated;
             std::atomic<State> state;
             std::exception_ptr exc;
+            TypeId id;
 
             /*
-             * We need this lock because a Promise might be resolved or rejected from a
-             * thread A while a continuation to the same Promise (Core) might be attached
-             * at the same from a thread B. If that's the case, then we need to serialize
-             * operations so that we avoid a race-condition.
+             * Continuations might be attached from a thread A while the
+             * promise is resolved or rejected from a thread B, and each one
+             * must run exactly once, either from A if the promise is settled
+             * already, or from B.
              *
-             * Since we have a lock, we have a blocking progress guarantee but I don't
-             * expect this to be a major bottleneck as I don't expect major contention on
-             * the lock If it ends up being a bottlenick, try @improving it by
-             * experimenting with a lock-free scheme
+             * A promise almost always has a single continuation, which is
+             * attached and run without locking: it goes to first_, and both
+             * sides raise a flag once done with their part, the one who sees
+             * the flag of the other being the one who runs it. The rare
+             * other continuations go to more_, under mtx: whoever of settle()
+             * and attach() takes mtx last runs them, settle() marking more_
+             * as taken over so that attach() never hands it one it runs too.
              */
-            std::mutex mtx;
-            std::vector<std::shared_ptr<Request>> requests;
-            TypeId id;
+            void attach(const std::shared_ptr<Core>& self, std::shared_ptr<Request> request)
+            {
+                if (!(flags_.load(std::memory_order_relaxed) & Claimed)
+                    && !(flags_.fetch_or(Claimed, std::memory_order_relaxed) & Claimed))
+                {
+                    first_ = std::move(request);
+                    if (flags_.fetch_or(Attached, std::memory_order_acq_rel) & Settled)
+                        run(self, *first_);
+                    return;
+                }
+
+                // settle() has already looked for more_, it is up to us
+                if (flags_.fetch_or(MoreAttached, std::memory_order_acq_rel) & Settled)
+                {
+                    run(self, *request);
+                    return;
+                }
+
+                // settle() will look for more_, unless it already has
+                std::unique_lock<std::mutex> guard(mtx);
+                if (moreTaken_)
+                {
+                    guard.unlock();
+                    run(self, *request);
+                    return;
+                }
+                more_.push_back(std::move(request));
+            }
+
+            // Runs the continuations attached so far, once the core has been
+            // fulfilled or rejected. Those attached later run right away.
+            void settle(const std::shared_ptr<Core>& self)
+            {
+                const auto flags = flags_.fetch_or(Settled, std::memory_order_acq_rel);
+                if (flags & Settled)
+                    return;
+
+                if (flags & Attached)
+                    run(self, *first_);
+
+                if (flags & MoreAttached)
+                {
+                    // Continuations attached from now on see moreTaken_, or
+                    // Settled, and run on their own
+                    std::unique_lock<std::mutex> guard(mtx);
+                    moreTaken_    = true;
+                    auto requests = std::move(more_);
+                    more_.clear();
+                    guard.unlock();
+
+                    for (const auto& req : requests)
+                        run(self, *req);
+                }
+            }
 
             virtual void* memory() = 0;
 
@@ -260,6 +416,29 @@ namespace Pistache::Async
             }
 
             virtual ~Core() = default;
+
+        private:
+            enum Flags : uint8_t {
+                Claimed      = 1, // first_ is being set
+                Attached     = 2, // first_ is set
+                MoreAttached = 4, // more_ is not empty
+                Settled      = 8
+            };
+
+            void run(const std::shared_ptr<Core>& self, Request& request)
+            {
+                if (state == State::Fulfilled)
+                    request.resolve(self);
+                else
+                    request.reject(self);
+            }
+
+            std::atomic<uint8_t> flags_ { 0 };
+            std::shared_ptr<Request> first_;
+
+            std::mutex mtx;
+            std::vector<std::shared_ptr<Request>> more_;
+            bool moreTaken_ = false;
         };
 
         template <typename T>
@@ -347,23 +526,25 @@ namespace Pistache::Async
                 }
                 catch (const InternalRethrow& e)
                 {
-                    chain_->exc   = e.exc;
-                    chain_->state = State::Rejected;
-                    for (const auto& req : chain_->requests)
-                    {
-                        if (req)
-                            req->reject(chain_);
-                    }
+                    rejectChain(e.exc);
                 }
             }
 
-            std::shared_ptr<CoreT<T>> coreCast(const std::shared_ptr<Core>& core) const
+            // Passes the rejection on to the continuations of the chain
+            void rejectChain(std::exception_ptr exc)
+            {
+                chain_->exc   = std::move(exc);
+                chain_->state = State::Rejected;
+                chain_->settle(chain_);
+            }
+
+            CoreT<T>& coreCast(const std::shared_ptr<Core>& core) const
             {
-                return std::static_pointer_cast<CoreT<T>>(core);
+                return static_cast<CoreT<T>&>(*core);
             }
 
-            virtual void doResolve(const std::shared_ptr<CoreT<T>>& core) = 0;
-            virtual void doReject(const std::shared_ptr<CoreT<T>>& core)  = 0;
+            virtual void doResolve(CoreT<T>& core) = 0;
+            virtual void doReject(CoreT<T>& core)  = 0;
 
             ~Continuable() override = default;
 
@@ -421,27 +602,23 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
-                void doResolve(const std::shared_ptr<CoreT<T>>& core) override
+                void doResolve(CoreT<T>& core) override
                 {
-                    finishResolve(resolve_(detail::tryMove<Resolve>(core->value())));
+                    finishResolve(resolve_(detail::tryMove<Resolve>(core.value())));
                 }
 
-                void doReject(const std::shared_ptr<CoreT<T>>& core) override
+                void doReject(CoreT<T>& core) override
                 {
-                    reject_(core->exc);
+                    reject_(core.exc);
                     /*
                      * reject_ is guaranteed to throw ("[[noreturn]]") so
-                     * doing this "for" loop is pointless
+                     * settling the chain here is pointless
                      *
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->reject(this->chain_);
-                    }
+                    this->chain_->settle(this->chain_);
                     */
                 }
 
@@ -450,11 +627,7 @@ namespace Pistache::Async
                 {
                     typedef typename std::decay<Ret>::type CleanRet;
                     this->chain_->template construct<CleanRet>(std::forward<Ret>(ret));
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->resolve(this->chain_);
-                    }
+                    this->chain_->settle(this->chain_);
                 }
 
                 Resolve resolve_;
@@ -470,26 +643,22 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 0,
                               "Can not attach a non-void continuation to a void-Promise");
 
-                void doResolve(const std::shared_ptr<CoreT<void>>& /*core*/) override
+                void doResolve(CoreT<void>& /*core*/) override
                 {
                     finishResolve(resolve_());
                 }
 
-                void doReject(const std::shared_ptr<CoreT<void>>& core) override
+                void doReject(CoreT<void>& core) override
                 {
-                    reject_(core->exc);
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->reject(this->chain_);
-                    }
+                    reject_(core.exc);
+                    this->rejectChain(core.exc);
                 }
 
                 template <typename Ret>
@@ -497,11 +666,7 @@ namespace Pistache::Async
                 {
                     typedef typename std::remove_reference<Ret>::type CleanRet;
                     this->chain_->template construct<CleanRet>(std::forward<Ret>(ret));
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->resolve(this->chain_);
-                    }
+                    this->chain_->settle(this->chain_);
                 }
 
                 Resolve resolve_;
@@ -516,8 +681,8 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 1,
@@ -528,14 +693,14 @@ namespace Pistache::Async
                 static_assert(std::is_same<T, Arg>::value || std::is_convertible<T, Arg>::value,
                               "Incompatible types detected");
 
-                void doResolve(const std::shared_ptr<CoreT<T>>& core) override
+                void doResolve(CoreT<T>& core) override
                 {
-                    resolve_(core->value());
+                    resolve_(core.value());
                 }
 
-                void doReject(const std::shared_ptr<CoreT<T>>& core) override
+                void doReject(CoreT<T>& core) override
                 {
-                    reject_(core->exc);
+                    reject_(core.exc);
                 }
 
                 Resolve resolve_;
@@ -551,21 +716,21 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 0,
                               "Can not attach a non-void continuation to a void-Promise");
 
-                void doResolve(const std::shared_ptr<CoreT<void>>& /*core*/) override
+                void doResolve(CoreT<void>& /*core*/) override
                 {
                     resolve_();
                 }
 
-                void doReject(const std::shared_ptr<CoreT<void>>& core) override
+                void doReject(CoreT<void>& core) override
                 {
-                    reject_(core->exc);
+                    reject_(core.exc);
                 }
 
                 Resolve resolve_;
@@ -590,28 +755,24 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
-                void doResolve(const std::shared_ptr<CoreT<T>>& core) override
+                void doResolve(CoreT<T>& core) override
                 {
-                    auto promise = resolve_(detail::tryMove<Resolve>(core->value()));
+                    auto promise = resolve_(detail::tryMove<Resolve>(core.value()));
                     finishResolve(promise);
                 }
 
-                void doReject(const std::shared_ptr<CoreT<T>>& core) override
+                void doReject(CoreT<T>& core) override
                 {
-                    reject_(core->exc);
+                    reject_(core.exc);
                     /*
                      * reject_ is guaranteed to throw ("[[noreturn]]") so
-                     * doing this "for" loop is pointless
+                     * settling the chain here is pointless
                      *
-                    for (const auto& req : core->requests)
-                    {
-                        if (req)
-                            req->reject(core);
-                    }
+                    this->chain_->settle(this->chain_);
                     */
                 }
 
@@ -625,11 +786,7 @@ namespace Pistache::Async
                     void operator()(const PromiseType& val)
                     {
                         chainCore->construct<PromiseType>(val);
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        chainCore->settle(chainCore);
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -653,11 +810,7 @@ namespace Pistache::Async
                             core->exc   = std::move(exc);
                             core->state = State::Rejected;
 
-                            for (const auto& req : core->requests)
-                            {
-                                if (req)
-                                    req->reject(core);
-                            }
+                            core->settle(core);
                         }
                     });
                 }
@@ -678,24 +831,20 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
-                void doResolve(const std::shared_ptr<CoreT<void>>& /*core*/) override
+                void doResolve(CoreT<void>& /*core*/) override
                 {
                     auto promise = resolve_();
                     finishResolve(promise);
                 }
 
-                void doReject(const std::shared_ptr<CoreT<void>>& core) override
+                void doReject(CoreT<void>& core) override
                 {
-                    reject_(core->exc);
-                    for (const auto& req : core->requests)
-                    {
-                        if (req)
-                            req->reject(core);
-                    }
+                    reject_(core.exc);
+                    this->rejectChain(core.exc);
                 }
 
                 template <typename PromiseType, typename Dummy = void>
@@ -708,11 +857,7 @@ namespace Pistache::Async
                     void operator()(const PromiseType& val)
                     {
                         chainCore->construct<PromiseType>(val);
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        chainCore->settle(chainCore);
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -729,11 +874,7 @@ namespace Pistache::Async
                     {
                         chainCore->state = State::Fulfilled;
 
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        chainCore->settle(chainCore);
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -755,11 +896,7 @@ namespace Pistache::Async
                         core->exc   = std::move(exc);
                         core->state = State::Rejected;
 
-                        for (const auto& req : core->requests)
-                        {
-                            if (req)
-                                req->reject(core);
-                        }
+                        core->settle(core);
                     });
                 }
 
@@ -869,14 +1006,9 @@ namespace Pistache::Async
                 throw Error("Attempt to resolve a void promise with arguments");
             }
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
             core_->construct<Type>(std::forward<Arg>(arg));
 
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->resolve(core_);
-            }
+            core_->settle(core_);
 
             return true;
         }
@@ -892,13 +1024,8 @@ namespace Pistache::Async
             if (!core_->isVoid())
                 throw Error("Attempt ro resolve a non-void promise with no argument");
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
             core_->state = State::Fulfilled;
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->resolve(core_);
-            }
+            core_->settle(core_);
 
             return true;
         }
@@ -933,14 +1060,9 @@ namespace Pistache::Async
             if (core_->state != State::Pending)
                 throw Error("Attempt to reject a fulfilled promise");
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
             core_->exc   = std::make_exception_ptr(exc);
             core_->state = State::Rejected;
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->reject(core_);
-            }
+            core_->settle(core_);
 
             return true;
         }
@@ -1075,7 +1197,7 @@ namespace Pistache::Async
 
         template <typename Func>
         explicit Promise(Func func)
-            : core_(std::make_shared<Core>())
+            : core_(Private::makeShared<Core>())
             , resolver_(core_)
             , rejection_(core_)
         {
@@ -1098,8 +1220,9 @@ namespace Pistache::Async
             static_assert(std::is_same<T, U>::value || std::is_convertible<U, T>::value,
                           "Incompatible value type");
 
-            auto core = std::make_shared<Core>();
+            auto core = Private::makeShared<Core>();
             core->template construct<T>(std::forward<U>(value));
+            core->settle(core);
             return Promise<T>(std::move(core));
         }
 
@@ -1108,17 +1231,19 @@ namespace Pistache::Async
             static_assert(std::is_void<T>::value,
                           "Resolving a non-void promise requires parameters");
 
-            auto core   = std::make_shared<Core>();
+            auto core   = Private::makeShared<Core>();
             core->state = State::Fulfilled;
+            core->settle(core);
             return Promise<T>(std::move(core));
         }
 
         template <typename Exc>
         static Promise<T> rejected(Exc exc)
         {
-            auto core   = std::make_shared<Core>();
+            auto core   = Private::makeShared<Core>();
             core->exc   = std::make_exception_ptr(exc);
             core->state = State::Rejected;
+            core->settle(core);
             return Promise<T>(std::move(core));
         }
 
@@ -1139,34 +1264,22 @@ namespace Pistache::Async
 
             typedef Private::Continuation<T, ResolveFunc, RejectFunc, ResolveFunc>
                 Continuation;
-            std::shared_ptr<Private::Request> req = std::make_shared<Continuation>(promise.core_, resolveFunc, rejectFunc);
-
-            std::unique_lock<std::mutex> guard(core_->mtx);
-            if (isFulfilled())
-            {
-                if (req)
-                    req->resolve(core_);
-            }
-            else if (isRejected())
-            {
-                if (req)
-                    req->reject(core_);
-            }
-
-            core_->requests.push_back(req);
+            core_->attach(core_, Private::makeShared<Continuation>(promise.core_,
+                                                                   std::move(resolveFunc),
+                                                                   std::move(rejectFunc)));
 
             return promise;
         }
 
     private:
         Promise()
-            : core_(std::make_shared<Core>())
+            : core_(Private::makeShared<Core>())
             , resolver_(core_)
             , rejection_(core_)
         { }
 
         explicit Promise(std::shared_ptr<Core>&& core)
-            : core_(core)
+            : core_(std::move(core))
             , resolver_(core_)
             , rejection_(core_)
         { }
@@ -1371,7 +1484,7 @@ namespace Pistache::Async
                 // Instead of allocating a new core, ideally we could share the same core as
                 // the relevant promise but we do not have access to the promise here is so
                 // meh
-                auto core = std::make_shared<Private::CoreT<T>>();
+                auto core = Private::makeShared<Private::CoreT<T>>();
                 core->template construct<T>(val);
                 data->resolve(Async::Any(core));
 
@@ -1386,7 +1499,7 @@ namespace Pistache::Async
                 if (data->done)
                     return;
 
-                auto core = std::make_shared<Private::CoreT<void>>();
+                auto core = Private::makeShared<Private::CoreT<void>>();
                 data->resolve(Async::Any(core));
 
                 data->done = true;
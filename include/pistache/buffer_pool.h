@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* buffer_pool.h
+
+   Reusable memory blocks for the receive buffers of the connections.
+
+   Blocks come in power of two sizes, starting at MinBlockSize. Every
+   thread keeps the blocks it releases for the next ones it acquires, so
+   that a worker serving keep-alive connections stops going through malloc
+   and free for each request once it has warmed up. Nothing is shared
+   between threads: a block released by another thread than the one that
+   acquired it just goes to the cache of the former.
+*/
+
+#pragma once
+
+#include <pistache/config.h>
+
+#include <cstddef>
+
+namespace Pistache
+{
+
+    class BufferPool
+    {
+    public:
+        static constexpr size_t MinBlockSize = Const::MaxBuffer;
+
+        // Larger blocks are allocated and freed every time
+        static constexpr size_t MaxPooledBlockSize = 1024 * 1024;
+
+        // How many bytes of blocks of a given size a thread keeps at most
+        static constexpr size_t MaxCachedBytes = 256 * 1024;
+
+        // Returns a block of at least size bytes, and stores its actual
+        // size back into size
+        static char* acquire(size_t& size);
+
+        // size is the one acquire() returned the block with
+        static void release(char* block, size_t size);
+
+        // Number of blocks cached by the calling thread
+        static size_t cached();
+    };
+
+} // namespace Pistache
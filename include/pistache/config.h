@@ -20,6 +20,18 @@ namespace Pistache::Const
     static constexpr size_t MaxBuffer      = 4096;
     static constexpr size_t DefaultWorkers = 1;
 
+    // Connections accepted at most each time a listening socket is found
+    // readable, before polling again
+    static constexpr size_t DefaultAcceptBudget = 64;
+
+    // Bytes read at most from a connection each time it is found readable,
+    // before the other connections of its worker get their turn
+    static constexpr size_t DefaultReadBudget = 256 * 1024;
+
+    // How long a connection accepted with Tcp::Options::DeferAccept may
+    // wait for its first bytes before being handed over anyway
+    static constexpr auto DeferAcceptTimeout = std::chrono::seconds(5);
+
     static constexpr size_t DefaultTimerPoolSize = 128;
 
     // Defined from CMakeLists.txt in project root
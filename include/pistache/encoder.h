@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* encoder.h
+
+   Compression of response bodies, for the content encodings pistache has
+   been built with.
+
+   Setting up the context of a compression library is costly, compared to
+   compressing a typical response. Every thread keeps the contexts of the
+   encoders it destroys, and hands them to the next encoders it creates
+   with the same encoding. Brotli has no way to reset an encoder, so its
+   state is created for each encoder.
+*/
+
+#pragma once
+
+#include <pistache/http_header.h>
+
+#include <cstddef>
+#include <string>
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+#include <zlib.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Pistache::Http
+{
+
+    class Encoder
+    {
+    public:
+        enum class Mode {
+            // Output whatever the library sees fit
+            Continue,
+            // Output everything compressed so far, so that the peer can
+            // already decode it
+            Flush,
+            // End the stream, the encoder can not be used anymore after that
+            Finish
+        };
+
+        // Throws std::runtime_error if pistache has not been built with
+        // support for encoding
+        Encoder(Header::Encoding encoding, int level);
+        ~Encoder();
+
+        Encoder(const Encoder&)            = delete;
+        Encoder& operator=(const Encoder&) = delete;
+
+        Header::Encoding encoding() const { return encoding_; }
+
+        // Compresses size bytes of data, appending the output to out
+        void compress(const char* data, size_t size, Mode mode, std::string& out);
+
+    private:
+        Header::Encoding encoding_;
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        BrotliEncoderState* brotli_ = nullptr;
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        z_stream* deflate_ = nullptr;
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        ZSTD_CCtx* zstd_ = nullptr;
+#endif
+    };
+
+} // namespace Pistache::Http
@@ -44,6 +44,55 @@ namespace Pistache::Http
             Options& maxRequestSize(size_t val);
             Options& maxResponseSize(size_t val);
 
+            // Only build the typed and raw forms of a request header when
+            // the handler looks it up, see Header::Collection::addLazy()
+            Options& lazyHeaders(bool val);
+
+            // Add a Date header to the responses that have none, see
+            // Http::Handler::setDateHeader()
+            Options& dateHeader(bool val);
+
+            // Add a Server header with this value to the responses that have
+            // none, see Http::Handler::setServerHeader()
+            Options& serverHeader(std::string val);
+
+            // Number of requests a connection may carry, see
+            // Http::Handler::setMaxRequestsPerConnection()
+            Options& maxRequestsPerConnection(size_t val);
+
+            // Once a worker thread holds more connections than that, it
+            // closes its idle keep-alive connections, the longest idle
+            // first, until it is back to the limit. Every connection holds
+            // a request buffer, up to maxRequestSize(). 0, the default,
+            // means no limit.
+            Options& connectionSoftLimit(size_t val);
+
+            // Give every worker thread its own SO_REUSEPORT listening socket,
+            // see Tcp::Listener::setReusePortAcceptors()
+            Options& reusePortAcceptors(bool val, bool incomingCpu = false);
+
+            // How new connections are spread over the worker threads, see
+            // Tcp::Listener::DispatchPolicy
+            Options& dispatchPolicy(Tcp::Listener::DispatchPolicy val);
+
+            // Connections accepted at most per wakeup of an accepting
+            // thread, see Tcp::Listener::setAcceptBudget()
+            Options& acceptBudget(size_t val);
+
+            // SO_RCVBUF and SO_SNDBUF of the connections, 0 keeping the size
+            // of the system, see Tcp::Listener::setSocketBufferSizes()
+            Options& socketBufferSizes(size_t receive, size_t send);
+
+            // Look the name of every connection up in the background once
+            // accepted, so that Peer::hostname() finds it cached, see
+            // Tcp::Listener::setResolveHostnames()
+            Options& resolveHostnames(bool val);
+
+            // Bytes read at most from a connection before the other
+            // connections of its worker thread get their turn, see
+            // Tcp::Transport::setReadBudget()
+            Options& readBudget(size_t val);
+
             template <typename Duration>
             Options& headerTimeout(Duration timeout)
             {
@@ -99,6 +148,20 @@ namespace Pistache::Http
             PISTACHE_STRING_LOGGER_T logger_;
             // This should be moved after "keepaliveTimeout_" in the next ABI change
             std::chrono::milliseconds sslHandshakeTimeout_;
+
+            bool lazyHeaders_;
+            bool dateHeader_;
+            std::string serverHeader_;
+            size_t maxRequestsPerConnection_;
+            size_t connectionSoftLimit_;
+            bool reusePortAcceptors_;
+            bool incomingCpu_;
+            Tcp::Listener::DispatchPolicy dispatchPolicy_;
+            size_t acceptBudget_;
+            size_t receiveBufferSize_;
+            size_t sendBufferSize_;
+            bool resolveHostnames_;
+            size_t readBudget_;
             Options();
         };
         Endpoint();
@@ -197,6 +260,8 @@ namespace Pistache::Http
         Async::Promise<Tcp::Listener::Load>
         requestLoad(const Tcp::Listener::Load& old);
 
+        Tcp::Listener::AcceptStats acceptStats() const { return listener.acceptStats(); }
+
         static Options options();
 
         std::vector<std::shared_ptr<Tcp::Peer>> getAllPeer();
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* file_cache.h
+
+   A cache for serving static files.
+
+   It does the same job as serveFile(), while keeping what it learns about
+   each file: its stat, its media type, an open descriptor, and even its
+   content for small files. A request for a cached file then costs a dup()
+   of the descriptor and a sendfile(), or a single write for a file held in
+   memory.
+
+   Files are checked again with stat() once revalidateAfter() has passed
+   since they were last checked, and reloaded if their size, modification
+   time or inode changed.
+
+   The cache also serves the precompressed siblings of a file, "name.br",
+   "name.zst" and "name.gz", to the clients that accept that encoding. A
+   file held in memory that has no such sibling is compressed the first
+   time it is asked for in an encoding pistache has been built with, and
+   the result is kept along with it.
+
+   A cache can be shared by all the worker threads.
+*/
+
+#pragma once
+
+#include <pistache/async.h>
+#include <pistache/http.h>
+#include <pistache/mime.h>
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace Pistache::Http
+{
+
+    class FileCache
+    {
+    public:
+        static constexpr size_t DefaultMaxMemoryFileSize = 64 * 1024;
+        static constexpr size_t DefaultMaxMemoryBytes    = 16 * 1024 * 1024;
+        static constexpr size_t DefaultMaxEntries        = 1024;
+
+        FileCache();
+        ~FileCache();
+
+        FileCache(const FileCache&)            = delete;
+        FileCache& operator=(const FileCache&) = delete;
+
+        // Files up to that size are held in memory, as long as the cache
+        // holds less than maxMemoryBytes() of them, compressed variants
+        // included
+        FileCache& maxMemoryFileSize(size_t size);
+        FileCache& maxMemoryBytes(size_t size);
+
+        // Beyond that many files, the cache forgets the least recently
+        // served one for each new file
+        FileCache& maxEntries(size_t count);
+
+        template <typename Duration>
+        FileCache& revalidateAfter(Duration duration)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            revalidateAfter_ = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+            return *this;
+        }
+
+        /*
+         * Sends fileName like serveFile() does, picking the variant that
+         * best matches the Accept-Encoding header of request. Each variant
+         * has its own ETag, and its conditional and Range headers are
+         * answered. Throws HttpError(Not_Found) if the file does not exist.
+         */
+        Async::Promise<PST_SSIZE_T>
+        serve(ResponseWriter& writer, const Request& request, const std::string& fileName,
+              const Mime::MediaType& contentType = Mime::MediaType());
+
+        // Number of files cached, and bytes held in memory for them
+        size_t size() const;
+        size_t memoryBytes() const;
+
+        void clear();
+
+    private:
+        struct Entry;
+
+        std::shared_ptr<const Entry> lookup(const std::string& fileName);
+        std::shared_ptr<const Entry> withVariant(const std::string& fileName,
+                                                 const std::shared_ptr<const Entry>& entry,
+                                                 Header::Encoding encoding);
+
+        void store(const std::string& fileName, std::shared_ptr<const Entry> entry);
+
+        // Called with mutex_ held
+        void evict();
+
+        // Most recently served first, indexed by the names they hold
+        using Lru = std::list<std::pair<std::string, std::shared_ptr<const Entry>>>;
+
+        mutable std::mutex mutex_;
+        Lru lru_;
+        std::unordered_map<std::string_view, Lru::iterator> entries_;
+        size_t memoryBytes_ = 0;
+
+        size_t maxMemoryFileSize_                 = DefaultMaxMemoryFileSize;
+        size_t maxMemoryBytes_                    = DefaultMaxMemoryBytes;
+        size_t maxEntries_                        = DefaultMaxEntries;
+        std::chrono::milliseconds revalidateAfter_ = std::chrono::seconds(1);
+    };
+
+} // namespace Pistache::Http
@@ -14,8 +14,13 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -264,6 +269,109 @@ namespace Pistache
 
         class Handler;
         class ResponseWriter;
+        class FileCache;
+
+        namespace Private
+        {
+
+            /*
+             * Puts the responses of a connection on the wire in the order of
+             * their requests (RFC 9112 section 9.3.2), however late a
+             * handler answers. The writes of a response are held until the
+             * responses before it are done with.
+             */
+            class ResponseSequencer
+            {
+            public:
+                using Write = std::function<Async::Promise<PST_SSIZE_T>()>;
+
+                // Numbers the response to the next request
+                uint64_t open();
+
+                // Calls write once the responses before response are done
+                // with, right away if they already are
+                template <typename Func>
+                Async::Promise<PST_SSIZE_T> write(uint64_t response, Func write)
+                {
+                    if (!enter(response))
+                        return hold(response, std::move(write));
+
+                    try
+                    {
+                        auto sent = write();
+                        leave();
+                        return sent;
+                    }
+                    catch (...)
+                    {
+                        leave();
+                        throw;
+                    }
+                }
+
+                // Lets the writes of the next response through, once
+                // response has been written
+                void close(uint64_t response);
+
+            private:
+                // Whether the writes of response can go right away, in
+                // which case the ones held stay so until leave()
+                bool enter(uint64_t response);
+                void leave();
+
+                Async::Promise<PST_SSIZE_T> hold(uint64_t response, Write write);
+
+                // Releases the writes that are due, mutex_ being held
+                void drain(std::unique_lock<std::mutex>& guard);
+
+                std::mutex mutex_;
+                uint64_t next_    = 0;
+                uint64_t current_ = 0;
+                bool draining_    = false;
+
+                std::map<uint64_t, std::vector<Async::Deferred<bool>>> held_;
+
+                // Responses closed before their turn
+                std::set<uint64_t> closed_;
+            };
+
+            /*
+             * The place of a response in the sequence of its connection,
+             * shared by the ResponseWriter answering it and its clones, or
+             * the ResponseStream it turned into. The response is done with
+             * once close() is called, or the last of them is gone.
+             */
+            class ResponseTurn
+            {
+            public:
+                explicit ResponseTurn(std::shared_ptr<ResponseSequencer> sequencer);
+
+                ResponseTurn(const ResponseTurn&)            = delete;
+                ResponseTurn& operator=(const ResponseTurn&) = delete;
+
+                ~ResponseTurn();
+
+                template <typename Func>
+                Async::Promise<PST_SSIZE_T> write(Func write)
+                {
+                    if (closed_.load(std::memory_order_acquire))
+                    {
+                        return Async::Promise<PST_SSIZE_T>::rejected(
+                            Error("Response already sent"));
+                    }
+
+                    return sequencer_->write(response_, std::move(write));
+                }
+
+                void close();
+
+            private:
+                std::shared_ptr<ResponseSequencer> sequencer_;
+                uint64_t response_;
+                std::atomic<bool> closed_ { false };
+            };
+
+        } // namespace Private
 
         class Timeout
         {
@@ -272,65 +380,45 @@ namespace Pistache
 
             explicit Timeout(Timeout&& other)
                 : handler(other.handler)
+                , version(other.version)
                 , transport(other.transport)
-                , armed(other.armed)
-                , timerFd(other.timerFd)
+                , timerId(other.timerId)
                 , peer(std::move(other.peer))
+                , turn(std::move(other.turn))
             {
                 // cppcheck-suppress useInitializationList
-                other.timerFd = PS_FD_EMPTY;
-                // For libevent, don't need to free, passed to this->timerFd
+                other.timerId = 0;
             }
 
             Timeout& operator=(Timeout&& other)
             {
+                disarm();
+
                 handler   = other.handler;
                 transport = other.transport;
                 version   = other.version;
-                armed     = other.armed;
-                timerFd   = other.timerFd;
+                timerId   = other.timerId;
 
-                other.timerFd = PS_FD_EMPTY;
-                // For libevent, don't need to free, passed to this->timerFd
+                other.timerId = 0;
 
                 peer = std::move(other.peer);
+                turn = std::move(other.turn);
                 return *this;
             }
 
             ~Timeout();
 
+            /*
+             * Calls Handler::onTimeout() once duration has elapsed, unless the
+             * timeout gets disarmed first, which sending the response does.
+             * Arming does not create a timer of its own: the deadline goes
+             * with the other ones of the transport, see
+             * Tcp::Transport::armTimeout().
+             */
             template <typename Duration>
             void arm(Duration duration)
             {
-                Async::Promise<uint64_t> p([duration, this](Async::Deferred<uint64_t> deferred) {
-#ifdef _USE_LIBEVENT
-                    std::shared_ptr<EventMethEpollEquiv>
-                        event_meth_epoll_equiv(
-                            transport->getEventMethEpollEquiv());
-                    if (!event_meth_epoll_equiv)
-                        throw std::runtime_error(
-                            "event_meth_epoll_equiv null");
-
-                    timerFd = TRY_NULL_RET(EventMethFns::em_timer_new(
-                        PST_CLOCK_MONOTONIC,
-                        F_SETFDL_NOTHING, PST_O_NONBLOCK,
-                        event_meth_epoll_equiv.get()));
-#else
-                    timerFd = TRY_RET(timerfd_create(PST_CLOCK_MONOTONIC, TFD_NONBLOCK));
-#endif
-                    transport->armTimer(timerFd, duration, std::move(deferred));
-                });
-
-                p.then(
-                    [this](uint64_t numWakeup) {
-                        this->armed = false;
-                        this->onTimeout(numWakeup);
-                        CLOSE_FD(timerFd);
-                        timerFd = PS_FD_EMPTY;
-                    },
-                    [](std::exception_ptr exc) { std::rethrow_exception(exc); });
-
-                armed = true;
+                armMs(std::chrono::duration_cast<std::chrono::milliseconds>(duration));
             }
 
             void disarm();
@@ -338,21 +426,38 @@ namespace Pistache
             bool isArmed() const;
 
         private:
-            Timeout(const Timeout& other) = default;
+            // A copy does not share the timeout armed by other, if any
+            Timeout(const Timeout& other);
 
             Timeout(Tcp::Transport* transport_, Http::Version version, Handler* handler_,
-                    std::weak_ptr<Tcp::Peer> peer_);
+                    std::weak_ptr<Tcp::Peer> peer_,
+                    std::weak_ptr<Private::ResponseTurn> turn_ = {});
+
+            void armMs(std::chrono::milliseconds duration);
 
-            void onTimeout(uint64_t numWakeup);
+            static void onTimeout(Handler* handler, Http::Version version,
+                                  Tcp::Transport* transport,
+                                  const std::weak_ptr<Tcp::Peer>& peer,
+                                  const std::weak_ptr<Private::ResponseTurn>& turn);
 
             Handler* handler;
             Http::Version version;
             Tcp::Transport* transport;
-            bool armed;
-            Fd timerFd;
+            Tcp::Transport::TimeoutId timerId;
             std::weak_ptr<Tcp::Peer> peer;
+
+            // Where the response sent on timeout goes
+            std::weak_ptr<Private::ResponseTurn> turn;
         };
 
+        class Encoder;
+
+        /*
+         * A response sent in chunks. When the ResponseWriter it comes from
+         * has compression enabled, what gets written is compressed as it
+         * goes, and every flush() sends a chunk with the output of the
+         * encoder up to that point.
+         */
         class ResponseStream final
         {
         public:
@@ -362,6 +467,8 @@ namespace Pistache
 
             ResponseStream& operator=(ResponseStream&& other);
 
+            ~ResponseStream();
+
             template <typename T>
             friend ResponseStream& operator<<(ResponseStream& stream, const T& val);
 
@@ -372,16 +479,31 @@ namespace Pistache
 
         private:
             ResponseStream(Message&& other, std::weak_ptr<Tcp::Peer> peer,
-                           Tcp::Transport* transport, Timeout timeout, size_t streamSize,
-                           size_t maxResponseSize);
+                           Tcp::Transport* transport, const Handler* handler,
+                           Timeout timeout, std::shared_ptr<Private::ResponseTurn> turn,
+                           size_t streamSize, size_t maxResponseSize,
+                           std::unique_ptr<Encoder> encoder = nullptr);
 
             std::shared_ptr<Tcp::Peer> peer() const;
 
+            // Compresses what has been written since the last call into a
+            // chunk
+            void encodeChunk(bool last);
+
+            // Writes buffer, after the responses to the requests before
+            // this one
+            Async::Promise<PST_SSIZE_T> putOnWire(RawBuffer buffer);
+
             Message response_;
             std::weak_ptr<Tcp::Peer> peer_;
             DynamicStreamBuf buf_;
             Tcp::Transport* transport_;
             Timeout timeout_;
+            std::shared_ptr<Private::ResponseTurn> turn_;
+
+            // Uncompressed data waiting for the encoder, if there is one
+            std::unique_ptr<Encoder> encoder_;
+            DynamicStreamBuf plain_;
         };
 
         inline ResponseStream& ends(ResponseStream& stream)
@@ -399,6 +521,13 @@ namespace Pistache
         template <typename T>
         ResponseStream& operator<<(ResponseStream& stream, const T& val)
         {
+            if (stream.encoder_)
+            {
+                std::ostream os(&stream.plain_);
+                os << val;
+                return stream;
+            }
+
             Size<T> size;
 
             std::ostream os(&stream.buf_);
@@ -437,16 +566,23 @@ namespace Pistache
 
             friend Async::Promise<PST_SSIZE_T>
             serveFile(ResponseWriter&, const std::string&, const Mime::MediaType&);
+            friend Async::Promise<PST_SSIZE_T>
+            serveFile(ResponseWriter&, const Request&, const std::string&,
+                      const Mime::MediaType&);
 
             friend class Handler;
             friend class Timeout;
+            friend class FileCache;
 
             ResponseWriter& operator=(const ResponseWriter& other) = delete;
 
             friend class Private::ResponseLineStep;
 
+            // Without a turn, the response is written as soon as it is sent,
+            // whether the responses before it have been or not
             ResponseWriter(Http::Version version, Tcp::Transport* transport,
-                           Handler* handler, std::weak_ptr<Tcp::Peer> peer);
+                           Handler* handler, std::weak_ptr<Tcp::Peer> peer,
+                           std::shared_ptr<Private::ResponseTurn> turn = nullptr);
 
             //
             // C++11: std::weak_ptr move constructor is C++14 only so the default
@@ -562,11 +698,43 @@ namespace Pistache
 
             Async::Promise<PST_SSIZE_T> putOnWire(const char* data, size_t len);
 
+            // A file to answer a request with. Its size bytes are either
+            // held in memory at data, or read from fd, which is then taken
+            // over: the transport closes it once done
+            struct FileContent
+            {
+                int fd           = -1;
+                const char* data = nullptr;
+                size_t size      = 0;
+
+                std::chrono::system_clock::time_point lastModified;
+                std::string etag;
+            };
+
+            // Opens fileName and sends it with putFileOnWire()
+            Async::Promise<PST_SSIZE_T> putFile(const Request* request,
+                                                const std::string& fileName,
+                                                const Mime::MediaType& contentType);
+
+            // Sends file with its ETag and Last-Modified headers. If there is
+            // a request, answers its conditional and Range headers too, with
+            // a 304, 412, 206 or 416 status where it applies
+            Async::Promise<PST_SSIZE_T> putFileOnWire(const Request* request,
+                                                      FileContent file);
+
+            void setCode(Code code) { response_.code_ = code; }
+
+            const Handler* handler() const { return timeout_.handler; }
+
+            // Level set for contentEncoding_
+            int compressionLevel() const;
+
             Response response_;
             std::weak_ptr<Tcp::Peer> peer_;
             DynamicStreamBuf buf_;
             Tcp::Transport* transport_ = nullptr;
             Timeout timeout_;
+            std::shared_ptr<Private::ResponseTurn> turn_;
             PST_SSIZE_T sent_bytes_ = 0;
 
             Http::Header::Encoding contentEncoding_ = Http::Header::Encoding::Identity;
@@ -590,9 +758,24 @@ namespace Pistache
         serveFile(ResponseWriter& writer, const std::string& fileName,
                   const Mime::MediaType& contentType = Mime::MediaType());
 
+        /*
+         * Same as above, answering the headers of request that make it
+         * conditional (If-None-Match, If-Modified-Since) or ask for some byte
+         * ranges of the file (Range, If-Range). The ETag of the file is
+         * derived from its size and modification time.
+         */
+        Async::Promise<PST_SSIZE_T>
+        serveFile(ResponseWriter& writer, const Request& request,
+                  const std::string& fileName,
+                  const Mime::MediaType& contentType = Mime::MediaType());
+
         namespace Private
         {
 
+            // The ETag of a file, made of its modification time and size
+            // like with most servers. The same for serveFile() and FileCache.
+            std::string fileETag(time_t mtime, size_t size);
+
             enum class State { Again,
                                Next,
                                Done };
@@ -607,6 +790,9 @@ namespace Pistache
                 virtual StepId id() const                 = 0;
                 virtual State apply(StreamCursor& cursor) = 0;
 
+                // Forgets any partial progress, called when the parser is reset
+                virtual void reset() { }
+
                 [[noreturn]] static void raise(const char* msg, Code code = Code::Bad_Request);
 
             protected:
@@ -624,6 +810,13 @@ namespace Pistache
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
+
+                void reset() override { scanPos = 0; }
+
+            private:
+                // Buffer position up to which the current line has already
+                // been scanned for its terminating CRLF
+                size_t scanPos = 0;
             };
 
             class ResponseLineStep : public Step
@@ -637,6 +830,13 @@ namespace Pistache
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
+
+                void reset() override { scanPos = 0; }
+
+            private:
+                // Buffer position up to which the current line has already
+                // been scanned for its terminating CRLF
+                size_t scanPos = 0;
             };
 
             class HeadersStep : public Step
@@ -650,6 +850,17 @@ namespace Pistache
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
+
+                void reset() override { scanPos = 0; }
+
+                // When set, headers are added with Header::Collection::addLazy()
+                void setLazy(bool value) { lazy = value; }
+
+            private:
+                // Buffer position up to which the current line has already
+                // been scanned for its terminating CRLF
+                size_t scanPos = 0;
+                bool lazy      = false;
             };
 
             class BodyStep : public Step
@@ -666,6 +877,12 @@ namespace Pistache
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
 
+                void reset() override
+                {
+                    chunk.reset();
+                    bytesRead = 0;
+                }
+
             private:
                 struct Chunk
                 {
@@ -677,6 +894,7 @@ namespace Pistache
                         : message(message_)
                         , bytesRead(0)
                         , size(-1)
+                        , alreadyAppendedChunkBytes(0)
                     { }
 
                     Result parse(StreamCursor& cursor);
@@ -685,11 +903,13 @@ namespace Pistache
                     {
                         bytesRead = 0;
                         size      = -1;
+                        scanPos   = 0;
                     }
 
                 private:
                     Message* message;
                     size_t bytesRead;
+                    size_t scanPos = 0;
                     PST_SSIZE_T size;
                     PST_SSIZE_T alreadyAppendedChunkBytes;
                 };
@@ -719,18 +939,49 @@ namespace Pistache
                 virtual ~ParserBase() = default;
 
                 bool feed(const char* data, size_t len);
+                // Feeds as much of data as the buffer has room for, and
+                // returns how many bytes that was
+                size_t feedSome(const char* data, size_t len);
+
+                // Lets up to len bytes be written straight into the buffer,
+                // see ArrayStreamBuf::prepare(), and returns nullptr if it
+                // is full. They are fed once passed to commit().
+                char* prepare(size_t& len);
+                void commit(size_t len);
+
                 virtual void reset();
                 State parse();
 
+                /*
+                 * Gets ready to parse the next message once parse() is Done.
+                 * Unlike reset(), this keeps the bytes that follow the parsed
+                 * message, such as pipelined requests.
+                 */
+                void nextMessage();
+
+                // Drops the messages parsed before the current one from the
+                // buffer, making room for more input, and returns false if
+                // there were none. The current message is kept whole, so
+                // that it still has to fit in the buffer.
+                bool compact();
+
                 Step* step();
 
+                void setLazyHeaders(bool lazy);
+
             protected:
+                // Clears the parsed message, without touching the buffer
+                virtual void resetMessage();
+
                 std::array<std::unique_ptr<Step>, StepsCount> allSteps;
                 size_t currentStep = 0;
 
             private:
                 ArrayStreamBuf<char> buffer;
                 StreamCursor cursor;
+
+                // Where the current message starts in buffer
+                size_t messageStart = 0;
             };
 
             template <typename Message>
@@ -742,8 +993,6 @@ namespace Pistache
             public:
                 explicit ParserImpl(size_t maxDataSize);
 
-                void reset() override;
-
                 std::chrono::steady_clock::time_point time() const
                 {
                     return time_;
@@ -751,6 +1000,19 @@ namespace Pistache
 
                 Request request;
 
+                // Requests read from the connection so far
+                size_t requests = 0;
+
+                // Set once the connection has carried its last request: any
+                // more input is dropped until the client closes it
+                bool closing = false;
+
+                // Orders the responses to the requests of the connection
+                std::shared_ptr<ResponseSequencer> responses;
+
+            protected:
+                void resetMessage() override;
+
             private:
                 std::chrono::steady_clock::time_point time_;
             };
@@ -784,6 +1046,27 @@ namespace Pistache
             void setMaxResponseSize(size_t value);
             size_t getMaxResponseSize() const;
 
+            // Whether request headers are only parsed on first lookup, see
+            // Header::Collection::addLazy()
+            void setLazyHeaders(bool value);
+            bool getLazyHeaders() const;
+
+            // Whether responses get a Date header, unless they already have
+            // one. Every thread formats it at most once per second.
+            void setDateHeader(bool value);
+            bool getDateHeader() const;
+
+            // Value of the Server header responses get, unless they already
+            // have one. Empty, the default, means no Server header.
+            void setServerHeader(std::string value);
+            const std::string& getServerHeader() const;
+
+            // Number of requests a connection may carry, the response to the
+            // last one telling the client it is closed. 0, the default, means
+            // no limit.
+            void setMaxRequestsPerConnection(size_t value);
+            size_t getMaxRequestsPerConnection() const;
+
             template <typename Duration>
             void setHeaderTimeout(Duration timeout)
             {
@@ -815,9 +1098,17 @@ namespace Pistache
             void onInput(const char* buffer, size_t len,
                          const std::shared_ptr<Tcp::Peer>& peer) override;
 
+            // Requests are read straight into the buffer of their parser
+            char* prepareInput(const std::shared_ptr<Tcp::Peer>& peer, size_t& size) override;
+            void commitInput(size_t len, const std::shared_ptr<Tcp::Peer>& peer) override;
+
         private:
             size_t maxRequestSize_  = Const::DefaultMaxRequestSize;
             size_t maxResponseSize_ = Const::DefaultMaxResponseSize;
+            bool lazyHeaders_       = false;
+            bool dateHeader_        = false;
+            std::string serverHeader_;
+            size_t maxRequestsPerConnection_ = 0;
 
             std::chrono::milliseconds headerTimeout_ = Const::DefaultHeaderTimeout;
             std::chrono::milliseconds bodyTimeout_   = Const::DefaultBodyTimeout;
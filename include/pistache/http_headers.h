@@ -13,12 +13,18 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include <pistache/http_header.h>
+#include <pistache/meta.h>
 #include <pistache/type_checkers.h>
 
 namespace Pistache::Http::Header
@@ -44,9 +50,9 @@ namespace Pistache::Http::Header
 
     struct LowercaseHash
     {
-        size_t operator()(const std::string& key) const
+        size_t operator()(std::string_view key) const
         {
-            return std::hash<std::string> {}(toLowercase(key));
+            return static_cast<size_t>(Meta::Hash::fnv1a_nocase(key.data(), key.size()));
         }
     };
 
@@ -55,50 +61,210 @@ namespace Pistache::Http::Header
 
     struct LowercaseEqual
     {
-        bool operator()(const std::string& left, const std::string& right) const
+        bool operator()(std::string_view left, std::string_view right) const
         {
             return std::equal(left.begin(), left.end(), right.begin(), right.end(),
                               [](const char& a, const char& b) {
-                                  return std::tolower(a) == std::tolower(b);
+                                  return std::tolower(static_cast<unsigned char>(a))
+                                      == std::tolower(static_cast<unsigned char>(b));
                               });
         };
     };
 
+    /*
+     * The headers registered by Pistache itself. This is their only list:
+     * Known::Names below and their registration in http_headers.cc are both
+     * generated from it.
+     */
+#define PISTACHE_KNOWN_HEADERS(X)  \
+    X(Accept)                      \
+    X(AccessControlAllowOrigin)    \
+    X(AccessControlAllowHeaders)   \
+    X(AccessControlExposeHeaders)  \
+    X(AccessControlAllowMethods)   \
+    X(Allow)                       \
+    X(CacheControl)                \
+    X(Connection)                  \
+    X(AcceptEncoding)              \
+    X(ContentEncoding)             \
+    X(TransferEncoding)            \
+    X(ContentLength)               \
+    X(ContentType)                 \
+    X(Authorization)               \
+    X(Date)                        \
+    X(Expect)                      \
+    X(Host)                        \
+    X(LastModified)                \
+    X(Location)                    \
+    X(Server)                      \
+    X(UserAgent)
+
+    /*
+     * These headers are thus known at compile time. Each of them is given a
+     * dense index through a perfect hash of its lowercase name, so that the
+     * Registry and a Collection can store them in plain arrays instead of
+     * string-keyed maps. Any other header falls back to these maps.
+     */
+    namespace Known
+    {
+        inline constexpr const char* Names[] = {
+#define PST_KNOWN_HEADER_NAME(Header) Header::Name,
+            PISTACHE_KNOWN_HEADERS(PST_KNOWN_HEADER_NAME)
+#undef PST_KNOWN_HEADER_NAME
+        };
+
+        inline constexpr size_t Count = std::size(Names);
+
+        // Index returned for a header that is not known
+        inline constexpr size_t None = Count;
+
+        namespace detail
+        {
+            inline constexpr size_t SlotBits = 6;
+            inline constexpr size_t Slots    = size_t(1) << SlotBits;
+
+            static_assert(Count < Slots, "Too many known headers for the hash table");
+
+            constexpr size_t length(const char* str)
+            {
+                size_t len = 0;
+                while (str[len] != '\0')
+                    ++len;
+                return len;
+            }
+
+            constexpr char lower(char c)
+            {
+                return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+            }
+
+            // The low bits of a FNV-1a hash only depend on the low bits of the
+            // input, so the slot is taken from the high bits instead
+            constexpr size_t slot(const char* str, size_t len, uint64_t seed)
+            {
+                return static_cast<size_t>(
+                    Meta::Hash::fnv1a_nocase(str, len, Meta::Hash::val64 ^ seed) >> (64 - SlotBits));
+            }
+
+            struct Table
+            {
+                bool perfect;
+                uint64_t seed;
+                std::array<uint8_t, Slots> index;
+            };
+
+            // Searches for the first seed that maps every known name to its
+            // own slot
+            constexpr Table makeTable()
+            {
+                for (uint64_t seed = 0; seed < 1024; ++seed)
+                {
+                    Table table { true, seed, {} };
+                    for (auto& index : table.index)
+                        index = uint8_t(None);
+
+                    for (size_t i = 0; i < Count && table.perfect; ++i)
+                    {
+                        auto& index   = table.index[slot(Names[i], length(Names[i]), seed)];
+                        table.perfect = index == None;
+                        index         = uint8_t(i);
+                    }
+
+                    if (table.perfect)
+                        return table;
+                }
+
+                return Table { false, 0, {} };
+            }
+
+            inline constexpr Table PerfectHash = makeTable();
+
+            static_assert(PerfectHash.perfect, "No perfect hash found for the known headers");
+        } // namespace detail
+
+        // Index of the header called name (case-insensitive), None if the
+        // header is not known
+        constexpr size_t index(std::string_view name)
+        {
+            const size_t index = detail::PerfectHash.index[detail::slot(name.data(), name.size(), detail::PerfectHash.seed)];
+            if (index == None)
+                return None;
+
+            const std::string_view known = Names[index];
+            if (known.size() != name.size())
+                return None;
+
+            for (size_t i = 0; i < name.size(); ++i)
+            {
+                if (detail::lower(known[i]) != detail::lower(name[i]))
+                    return None;
+            }
+
+            return index;
+        }
+
+        template <typename H>
+        inline constexpr size_t IndexOf = index(H::Name);
+    } // namespace Known
+
+    /*
+     * A Collection can be filled lazily with addLazy(): the name and value
+     * of such headers are only copied, once, into a contiguous buffer owned
+     * by the collection. Their raw and strongly typed forms are only built
+     * when they are first looked up by name (get(), tryGet(), has(),
+     * getRaw()...) or when the whole list is requested (list(), rawList()).
+     *
+     * Since this first lookup modifies the collection, a collection that
+     * still holds lazy headers must not be read concurrently from several
+     * threads.
+     */
     class Collection
     {
     public:
         Collection()
-            : headers()
+            : knownHeaders()
+            , headers()
             , rawHeaders()
+            , lazyHeaders()
+            , lazyBytes()
         { }
 
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<const H>>::type
         get() const
         {
-            return std::static_pointer_cast<const H>(get(H::Name));
+            auto header = getImpl(H::Name, Known::IndexOf<H>);
+            if (!header.first)
+                throw std::runtime_error("Could not find header");
+
+            return std::static_pointer_cast<const H>(header.second);
         }
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<H>>::type get()
         {
-            return std::static_pointer_cast<H>(get(H::Name));
+            auto header = getImpl(H::Name, Known::IndexOf<H>);
+            if (!header.first)
+                throw std::runtime_error("Could not find header");
+
+            return std::static_pointer_cast<H>(header.second);
         }
 
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<const H>>::type
         tryGet() const
         {
-            return std::static_pointer_cast<const H>(tryGet(H::Name));
+            return std::static_pointer_cast<const H>(getImpl(H::Name, Known::IndexOf<H>).second);
         }
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<H>>::type
         tryGet()
         {
-            return std::static_pointer_cast<H>(tryGet(H::Name));
+            return std::static_pointer_cast<H>(getImpl(H::Name, Known::IndexOf<H>).second);
         }
 
         Collection& add(const std::shared_ptr<Header>& header);
         Collection& addRaw(const Raw& raw);
+        Collection& addLazy(std::string_view name, std::string_view value);
 
         template <typename H, typename... Args>
         typename std::enable_if<IsHeader<H>::value, Collection&>::type
@@ -124,15 +290,34 @@ namespace Pistache::Http::Header
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, bool>::type has() const
         {
-            return has(H::Name);
+            return getImpl(H::Name, Known::IndexOf<H>).first;
         }
         bool has(const std::string& name) const;
 
         std::vector<std::shared_ptr<Header>> list() const;
 
+        // Calls fn with every header, in the order of list(), without
+        // building the list
+        template <typename Fn>
+        void forEach(Fn&& fn) const
+        {
+            materializeAll();
+
+            for (const auto& h : knownHeaders)
+            {
+                if (h)
+                    fn(*h);
+            }
+            for (const auto& h : headers)
+            {
+                fn(*h.second);
+            }
+        }
+
         const std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>&
         rawList() const
         {
+            materializeAll();
             return rawHeaders;
         }
 
@@ -141,14 +326,36 @@ namespace Pistache::Http::Header
         void clear();
 
     private:
+        struct LazyHeader
+        {
+            size_t nameOffset;
+            size_t nameSize;
+            size_t valueOffset;
+            size_t valueSize;
+        };
+
         std::pair<bool, std::shared_ptr<Header>>
-        getImpl(const std::string& name) const;
+        getImpl(std::string_view name, size_t knownIndex) const;
 
-        std::unordered_map<std::string, std::shared_ptr<Header>, LowercaseHash,
-                           LowercaseEqual>
+        // Inserts header, unless a header with the same name is already there
+        void insert(const std::shared_ptr<Header>& header, size_t knownIndex) const;
+
+        void materialize(std::string_view name) const;
+        void materializeAll() const;
+
+        // Typed headers, known ones are stored at their Known::index()
+        mutable std::array<std::shared_ptr<Header>, Known::Count> knownHeaders;
+        // Other typed headers, keyed by their name(), which lives as long
+        // as the header itself; so looking them up takes no copy of the name
+        mutable std::unordered_map<std::string_view, std::shared_ptr<Header>, LowercaseHash,
+                                   LowercaseEqual>
             headers;
-        std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>
+        mutable std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>
             rawHeaders;
+
+        // Headers added with addLazy() that have not been looked up yet
+        mutable std::vector<LazyHeader> lazyHeaders;
+        std::string lazyBytes;
     };
 
     class Registry
@@ -182,6 +389,10 @@ namespace Pistache::Http::Header
 
         void registerHeader(const std::string& name, RegistryFunc func);
 
+        const RegistryFunc* find(const std::string& name) const;
+
+        // Known headers are stored at their Known::index()
+        std::array<RegistryFunc, Known::Count> knownRegistry;
         RegistryStorageType registry;
     };
 
@@ -26,7 +26,10 @@
 
 #include PST_SYS_RESOURCE_HDR
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <thread>
 #include <vector>
 
@@ -55,6 +58,50 @@ namespace Pistache::Tcp
             TimePoint tick;
         };
 
+        /*
+         * How the accept thread picks the worker that a new connection is
+         * handed to.
+         *
+         * Default:           the peer's fd modulo the number of workers (a
+         *                    rolling counter on Windows)
+         * RoundRobin:        each worker in turn
+         * LeastConnections:  the worker currently holding the fewest peers
+         * PowerOfTwoChoices: the less busy of two workers picked at random
+         *
+         * LeastConnections and PowerOfTwoChoices count a peer from the time
+         * it is dispatched, and also take into account the CPU load of the
+         * workers measured by the last requestLoad().
+         */
+        enum class DispatchPolicy {
+            Default,
+            RoundRobin,
+            LeastConnections,
+            PowerOfTwoChoices
+        };
+
+        /*
+         * What the accept queues of the listening sockets look like, to size
+         * the backlog and the accept budget.
+         *
+         * queued and backlog are the connections currently waiting to be
+         * accepted and the room there is for them, summed over the listening
+         * sockets. listenOverflows and listenDrops are the ListenOverflows
+         * and ListenDrops counters of the whole network namespace: how many
+         * connections were dropped because an accept queue was full, and for
+         * any reason while listening. They are only available on Linux, and
+         * 0 elsewhere.
+         */
+        struct AcceptStats
+        {
+            uint64_t accepted = 0;
+
+            size_t queued  = 0;
+            size_t backlog = 0;
+
+            uint64_t listenOverflows = 0;
+            uint64_t listenDrops     = 0;
+        };
+
         using TransportFactory = std::function<std::shared_ptr<Transport>()>;
 
         Listener();
@@ -88,6 +135,47 @@ namespace Pistache::Tcp
 
         void pinWorker(size_t worker, const CpuSet& set);
 
+        /*
+         * Instead of a single accept thread handing connections over to the
+         * workers, give each worker its own SO_REUSEPORT listening socket,
+         * polled by the worker itself, and let the kernel balance incoming
+         * connections between them.
+         *
+         * With incomingCpu, a BPF program is attached to the group of
+         * sockets so that a connection goes to the worker whose index is
+         * the CPU that received it (modulo the number of workers), which
+         * keeps a connection on one CPU when workers are pinned accordingly.
+         *
+         * Must be called before bind(). Only available on Linux; elsewhere
+         * the single accept thread is used.
+         */
+        void setReusePortAcceptors(bool enable, bool incomingCpu = false);
+
+        /*
+         * Number of connections accepted at most each time a listening
+         * socket is found readable, before polling again. Defaults to
+         * Const::DefaultAcceptBudget. Must be called before bind().
+         */
+        void setAcceptBudget(size_t budget);
+
+        /*
+         * SO_RCVBUF and SO_SNDBUF of the listening sockets, which accepted
+         * connections inherit. 0, the default, keeps the size of the system.
+         * Must be called before bind().
+         */
+        void setSocketBufferSizes(size_t receive, size_t send);
+
+        /*
+         * Start looking up the name of every peer as soon as it is
+         * accepted, see Peer::resolveHostname(). Off by default.
+         */
+        void setResolveHostnames(bool enable);
+
+        AcceptStats acceptStats() const;
+
+        void setDispatchPolicy(DispatchPolicy policy);
+        DispatchPolicy dispatchPolicy() const;
+
         void setupSSL(const std::string& cert_path, const std::string& key_path,
                       bool use_compression, int (*cb_password)(char*, int, int, void*),
                       std::chrono::milliseconds sslHandshakeTimeout = Const::DefaultSSLHandshakeTimeout);
@@ -117,10 +205,17 @@ namespace Pistache::Tcp
         TransportFactory defaultTransportFactory() const;
 
         bool bindListener(const struct addrinfo* addr);
+        void bindAcceptors(const struct addrinfo* addr);
+        void setBufferSizes(em_socket_t actualFd) const;
 
         void handleNewConnection();
-        em_socket_t acceptConnection(struct sockaddr_storage& peer_addr) const;
+        std::shared_ptr<Peer> acceptPeer(Fd listenFd);
+        em_socket_t acceptConnection(Fd listenFd, struct sockaddr_storage& peer_addr) const;
         void dispatchPeer(const std::shared_ptr<Peer>& peer);
+        size_t pickWorker(const std::vector<std::shared_ptr<Aio::Handler>>& handlers,
+                          em_socket_t actualFd);
+        double workerCost(const std::vector<std::shared_ptr<Aio::Handler>>& handlers,
+                          size_t idx) const;
 
 #ifdef _IS_WINDOWS
         std::atomic<em_socket_t> idxCtr_ = 1;
@@ -132,6 +227,27 @@ namespace Pistache::Tcp
 
         // This should be moved after "ssl_ctx_" in the next ABI change
         std::chrono::milliseconds sslHandshakeTimeout_ = Const::DefaultSSLHandshakeTimeout;
+
+        // Per-worker listening sockets, see setReusePortAcceptors()
+        bool reusePortAcceptors_ = false;
+        bool incomingCpu_        = false;
+        std::vector<Fd> acceptorFds_;
+
+        size_t acceptBudget_ = Const::DefaultAcceptBudget;
+        size_t receiveBufferSize_ = 0;
+        size_t sendBufferSize_    = 0;
+
+        bool resolveHostnames_ = false;
+
+        // Counted by whichever thread accepts
+        std::atomic<uint64_t> accepted_ { 0 };
+
+        DispatchPolicy dispatchPolicy_ = DispatchPolicy::Default;
+        std::atomic<size_t> dispatchCtr_ { 0 };
+        std::minstd_rand dispatchRng_;
+        // The per-worker CPU load of the last requestLoad()
+        mutable std::mutex dispatchLoadMutex_;
+        std::vector<double> dispatchLoad_;
     };
 
 } // namespace Pistache::Tcp
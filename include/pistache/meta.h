@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace Pistache::Meta::Hash
@@ -17,4 +18,16 @@ namespace Pistache::Meta::Hash
     {
         return (str[0] == '\0') ? value : fnv1a(&str[1], (value ^ uint64_t(str[0])) * prime64);
     }
+
+    // ASCII case-insensitive variant of fnv1a() over the first len chars of str
+    inline constexpr uint64_t fnv1a_nocase(const char* const str, const size_t len,
+                                           uint64_t value = val64) noexcept
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            const char c = (str[i] >= 'A' && str[i] <= 'Z') ? char(str[i] - 'A' + 'a') : str[i];
+            value        = (value ^ uint64_t(c)) * prime64;
+        }
+        return value;
+    }
 } // namespace Pistache::Meta::Hash
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -32,11 +34,13 @@
 namespace Pistache::Tcp
 {
 
+    class Listener;
     class Transport;
 
     class Peer
     {
     public:
+        friend class Listener;
         friend class Transport;
         friend class Http::Handler;
         friend class Http::Timeout;
@@ -52,12 +56,26 @@ namespace Pistache::Tcp
         bool isIdle() const;
 
         const Address& address() const;
+
+        // Name of the peer, or an empty string if it has none. Looked up on
+        // first use, which blocks unless the resolver has it cached, see
+        // resolveHostname()
         const std::string& hostname();
+
+        // Looks the name of the peer up without blocking, on a thread of
+        // ReverseResolver, which caches it for hostname() as well
+        Async::Promise<std::string> resolveHostname() const;
+
         Fd fd() const; // can return PS_FD_EMPTY
         em_socket_t actualFd() const; // can return -1
 
         void closeFd();
 
+        // Sends the client the end of the stream, while still letting it
+        // close the connection from its side (RFC 9112 section 9.6). The
+        // peer goes on until then, or until it times out.
+        void shutdownWrite();
+
         void* ssl() const;
 
         void putData(std::string name, std::shared_ptr<void> data);
@@ -92,8 +110,23 @@ namespace Pistache::Tcp
         std::unordered_map<std::string, std::shared_ptr<void>> data_;
 
         void* ssl_ = nullptr;
+
+        // Set by the Listener on SSL peers whose TLS handshake has not been
+        // done yet; the Transport then drives it before calling onConnection
+        bool handshakePending_ = false;
+        std::chrono::steady_clock::time_point handshakeDeadline_ = std::chrono::steady_clock::time_point::max();
+
         const size_t id_;
         bool isIdle_ = false;
+
+        // Set by the Transport while the peer waits to be read again, having
+        // used up its read budget
+        bool readPending_ = false;
+
+        // Set by the Transport, under its write lock, while the peer has
+        // writes queued, so that its writable edges need not look at the
+        // write queues otherwise. Read without the lock, hence atomic.
+        std::atomic<bool> writesPending_ { false };
     };
 
     std::ostream& operator<<(std::ostream& os, Peer& peer);
@@ -78,6 +78,10 @@ int pist_sock_listen(em_socket_t em_sock, int backlog);
 PST_SSIZE_T pist_sock_send(em_socket_t em_sock, const void *buf,
                            size_t len, int flags);
 
+// how is SD_RECEIVE, SD_SEND or SD_BOTH. On success, returns 0. On failure,
+// -1 is returned and errno is set.
+int pist_sock_shutdown(em_socket_t em_sock, int how);
+
 // On success, returns the number of bytes received. On error, -1 is
 // returned and errno is set. Returns 0 if connection closed gracefully.
 PST_SSIZE_T pist_sock_recv(em_socket_t em_sock, void * buf, size_t len,
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* resolver.h
+
+   Reverse DNS lookups of peer addresses.
+
+   A lookup can take seconds, when the DNS server is slow or does not
+   answer, so it is not something to do on a worker thread. The resolver
+   does it on a small pool of threads of its own, and hands the name back
+   through a promise.
+
+   Names are kept in a cache shared by the whole process, keyed by the IP
+   address, for ttl() once found and for negativeTtl() when the address has
+   no name. Beyond maxEntries() addresses, the least recently used one is
+   forgotten. Lookups of an address that is already being looked up wait
+   for that lookup rather than starting another one.
+
+   At most maxPending() addresses are looked up or waiting to be at a
+   time; resolve() fails the lookup of any other address until some of
+   them are done, rather than queueing it behind a slow DNS server.
+*/
+
+#pragma once
+
+#include <pistache/async.h>
+#include <pistache/net.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace Pistache
+{
+
+    class ReverseResolver
+    {
+    public:
+        static constexpr size_t DefaultThreads    = 2;
+        static constexpr size_t DefaultMaxEntries = 4096;
+        static constexpr size_t DefaultMaxPending = 1024;
+
+        // The one resolver of the process
+        static ReverseResolver& instance();
+
+        ~ReverseResolver();
+
+        ReverseResolver(const ReverseResolver&)            = delete;
+        ReverseResolver& operator=(const ReverseResolver&) = delete;
+
+        /*
+         * Name of address, or an empty string if it has none. Resolved right
+         * away when the name is cached, otherwise on a resolver thread, on
+         * which the continuations of the promise then run. Unix domain
+         * addresses are "localhost". Rejected when maxPending() addresses
+         * are already pending.
+         */
+        Async::Promise<std::string> resolve(const Address& address);
+
+        // Same as resolve(), but looks the name up on the calling thread
+        // when it is not cached, or waits for the lookup already under way
+        std::string resolveNow(const Address& address);
+
+        // The name of address if it is cached, whether empty or not
+        std::optional<std::string> cached(const Address& address) const;
+
+        ReverseResolver& maxEntries(size_t count);
+        ReverseResolver& maxPending(size_t count);
+
+        template <typename Duration>
+        ReverseResolver& ttl(Duration duration)
+        {
+            setTtl(std::chrono::duration_cast<std::chrono::milliseconds>(duration));
+            return *this;
+        }
+
+        template <typename Duration>
+        ReverseResolver& negativeTtl(Duration duration)
+        {
+            setNegativeTtl(std::chrono::duration_cast<std::chrono::milliseconds>(duration));
+            return *this;
+        }
+
+        // Number of addresses cached
+        size_t size() const;
+
+        void clear();
+
+    private:
+        struct State;
+
+        ReverseResolver();
+
+        void setTtl(std::chrono::milliseconds ttl);
+        void setNegativeTtl(std::chrono::milliseconds ttl);
+
+        // Shared with the threads of the pool, which the destructor
+        // detaches rather than waiting for their lookups
+        std::shared_ptr<State> state_;
+    };
+
+} // namespace Pistache
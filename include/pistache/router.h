@@ -12,9 +12,12 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -107,6 +110,66 @@ namespace Pistache::Rest
         class RouterHandler;
     }
 
+    /**
+     * Parameters and splats collected while matching a request against a
+     * SegmentTreeNode, stored inline as views into the matched resource and
+     * into the route tree, so only valid while both are. No allocation is
+     * performed while matching; if a route has more than MaxEntries
+     * parameters and splats, the match is flagged as overflowed and the
+     * caller should use the owning SegmentTreeNode::findRoute() instead.
+     */
+    class RouteMatch
+    {
+    public:
+        static constexpr size_t MaxEntries = 16;
+
+        struct Entry
+        {
+            std::string_view name;
+            std::string_view value;
+            bool splat;
+        };
+
+        RouteMatch()
+            : entries_()
+            , size_(0)
+            , overflowed_(false)
+        { }
+
+        bool push(std::string_view name, std::string_view value, bool splat)
+        {
+            if (size_ == MaxEntries)
+            {
+                overflowed_ = true;
+                return false;
+            }
+            entries_[size_++] = Entry { name, value, splat };
+            return true;
+        }
+
+        void pop() { --size_; }
+
+        void clear()
+        {
+            size_       = 0;
+            overflowed_ = false;
+        }
+
+        bool overflowed() const { return overflowed_; }
+
+        size_t size() const { return size_; }
+        const Entry* begin() const { return entries_.data(); }
+        const Entry* end() const { return entries_.data() + size_; }
+
+        std::vector<TypedParam> params() const;
+        std::vector<TypedParam> splats() const;
+
+    private:
+        std::array<Entry, MaxEntries> entries_;
+        size_t size_;
+        bool overflowed_;
+    };
+
     /**
      * A request URI is made of various path segments.
      * Since all routes handled by a router are naturally
@@ -227,6 +290,19 @@ namespace Pistache::Rest
         std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>,
                    std::vector<TypedParam>>
         findRoute(const std::string_view& path) const;
+
+        /**
+         * Allocation-free variant of findRoute().
+         * \param[in] path Requested resource path. Unlike findRoute(), the
+         * path does not need to be sanitized: empty segments (leading,
+         * trailing and multiple slashes) are skipped while walking the tree,
+         * which gives the same result as sanitizeResource().
+         * \param[out] match Receives views of the parsed parameters and
+         * splats. Views into \p path are only valid as long as \p path is.
+         * \return Found route, or a null pointer if no route matches or if
+         * \p match overflowed.
+         */
+        const Route* matchRoute(std::string_view path, RouteMatch& match) const;
     };
 
     class Router
@@ -316,11 +392,27 @@ namespace Pistache::Rest
         };
     } // namespace Private
 
+    /**
+     * A request matched by the Router. Up to InlineEntries parameters and
+     * splats of a route matched without allocating are kept inline, as
+     * offsets into the resource, with the names of the parameters copied
+     * together into a single string. They are only turned into TypedParam
+     * when asked for.
+     */
     class Request : public Http::Request
     {
     public:
         friend class Router;
 
+        static constexpr size_t InlineEntries = 4;
+
+        Request(const Request& other)            = default;
+        Request(Request&& other)                 = default;
+        Request& operator=(const Request& other);
+        Request& operator=(Request&& other) = default;
+
+        ~Request() = default;
+
         bool hasParam(const std::string& name) const;
         TypedParam param(const std::string& name) const;
 
@@ -332,8 +424,33 @@ namespace Pistache::Rest
                          std::vector<TypedParam>&& params,
                          std::vector<TypedParam>&& splats);
 
+        // match holds views into matchedResource, which has the same
+        // content as the resource of request
+        Request(Http::Request request, const RouteMatch& match,
+                std::string_view matchedResource);
+
+        // A parameter or splat kept inline. Splats have no name.
+        struct Entry
+        {
+            static constexpr uint32_t Splat = UINT32_MAX;
+
+            uint32_t name;
+            uint32_t nameSize;
+            uint32_t value;
+            uint32_t valueSize;
+        };
+
+        std::string_view nameOf(const Entry& entry) const;
+        std::string_view valueOf(const Entry& entry) const;
+
+        // Set when the route had more than InlineEntries of them, or was
+        // not matched by SegmentTreeNode::matchRoute()
         std::vector<TypedParam> params_;
         std::vector<TypedParam> splats_;
+
+        std::array<Entry, InlineEntries> entries_ {};
+        size_t entriesSize_ = 0;
+        std::string names_;
     };
 
     namespace Routes
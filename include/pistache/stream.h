@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <pistache/buffer_pool.h>
 #include <pistache/os.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <iostream>
@@ -21,6 +23,7 @@
 #include <stdexcept>
 #include <streambuf>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Pistache
@@ -93,54 +96,202 @@ namespace Pistache
         }
     };
 
-    // Make the buffer dynamic
+    // Make the buffer dynamic. Its memory comes from the BufferPool, and
+    // goes back to it whenever the buffer gets empty.
     template <typename CharT = char>
     class ArrayStreamBuf : public StreamBuf<CharT>
     {
+        static_assert(sizeof(CharT) == 1, "BufferPool blocks are made of bytes");
+
     public:
         using Base = StreamBuf<CharT>;
 
         explicit ArrayStreamBuf(size_t maxSize)
             : StreamBuf<CharT>()
-            , bytes()
             , maxSize_(maxSize)
         {
-            bytes.clear();
-            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            Base::setg(nullptr, nullptr, nullptr);
         }
 
         template <size_t M>
         explicit ArrayStreamBuf(char (&arr)[M])
         {
-            bytes.clear();
-            std::copy(arr, arr + M, std::back_inserter(bytes));
-            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            reserve(M);
+            std::copy(arr, arr + M, data_);
+            size_ = M;
+            Base::setg(data_, data_, data_ + size_);
+        }
+
+        // A copy gets a block of its own, with the same bytes and read
+        // position
+        ArrayStreamBuf(const ArrayStreamBuf& other)
+            : StreamBuf<CharT>()
+            , maxSize_(other.maxSize_)
+        {
+            Base::setg(nullptr, nullptr, nullptr);
+            copyFrom(other);
+        }
+
+        ArrayStreamBuf& operator=(const ArrayStreamBuf& other)
+        {
+            if (this != &other)
+            {
+                reset();
+                maxSize_ = other.maxSize_;
+                copyFrom(other);
+            }
+            return *this;
+        }
+
+        // A move takes the block over, leaving other empty
+        ArrayStreamBuf(ArrayStreamBuf&& other) noexcept
+            : StreamBuf<CharT>()
+            , maxSize_(other.maxSize_)
+        {
+            Base::setg(nullptr, nullptr, nullptr);
+            takeFrom(other);
+        }
+
+        ArrayStreamBuf& operator=(ArrayStreamBuf&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                maxSize_ = other.maxSize_;
+                takeFrom(other);
+            }
+            return *this;
         }
 
+        ~ArrayStreamBuf() override { BufferPool::release(reinterpret_cast<char*>(data_), capacity_); }
+
         bool feed(const char* data, size_t len)
         {
-            if (bytes.size() + len > maxSize_)
+            if (size_ + len > maxSize_)
             {
                 return false;
             }
-            // persist current offset
-            size_t readOffset = static_cast<size_t>(this->gptr() - this->eback());
-            std::copy(data, data + len, std::back_inserter(bytes));
-            Base::setg(bytes.data(), bytes.data() + readOffset,
-                       bytes.data() + bytes.size());
+
+            reserve(size_ + len);
+            std::memcpy(data_ + size_, data, len);
+            commit(len);
             return true;
         }
 
+        /*
+         * Returns where up to len more bytes can be written in place, e.g.
+         * by reading from a socket, and lowers len to how many fit. That
+         * is never more than room(), nor than what the buffer has left when
+         * it is not full. The bytes only become readable once commit()ted.
+         */
+        CharT* prepare(size_t& len)
+        {
+            len = std::min(len, room());
+            if (size_ < capacity_)
+                len = std::min(len, capacity_ - size_);
+            else if (len > 0)
+                reserve(size_ + len);
+
+            return data_ + size_;
+        }
+
+        void commit(size_t len)
+        {
+            size_ += len;
+            Base::setg(data_, this->gptr() ? this->gptr() : data_, data_ + size_);
+        }
+
         void reset()
         {
-            std::vector<CharT> nbytes;
-            bytes.swap(nbytes);
-            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            BufferPool::release(reinterpret_cast<char*>(data_), capacity_);
+            data_     = nullptr;
+            size_     = 0;
+            capacity_ = 0;
+            Base::setg(nullptr, nullptr, nullptr);
+        }
+
+        // Drops the bytes that have already been read, so that only the
+        // unread ones are kept and count towards maxSize
+        void compact() { compact(static_cast<size_t>(this->gptr() - this->eback())); }
+
+        // Drops only the first count of the bytes already read, the read
+        // position staying on the same byte
+        void compact(size_t count)
+        {
+            const size_t readOffset = static_cast<size_t>(this->gptr() - this->eback());
+            count                   = std::min(count, readOffset);
+            if (count == 0)
+                return;
+
+            if (count >= size_)
+            {
+                reset();
+                return;
+            }
+
+            size_ -= count;
+            std::memmove(data_, data_ + count, size_);
+            Base::setg(data_, data_ + (readOffset - count), data_ + size_);
+        }
+
+        // How many more bytes feed() accepts
+        size_t room() const
+        {
+            return size_ < maxSize_ ? maxSize_ - size_ : 0;
         }
 
     private:
-        std::vector<CharT> bytes;
-        size_t maxSize_ = Const::MaxBuffer;
+        // Moves to a block of at least capacity bytes, keeping the bytes
+        // and the read position
+        void reserve(size_t capacity)
+        {
+            if (capacity <= capacity_)
+                return;
+
+            const size_t readOffset = static_cast<size_t>(this->gptr() - this->eback());
+
+            size_t blockSize = capacity;
+            auto* block      = reinterpret_cast<CharT*>(BufferPool::acquire(blockSize));
+            if (size_ > 0)
+                std::memcpy(block, data_, size_);
+            BufferPool::release(reinterpret_cast<char*>(data_), capacity_);
+
+            data_     = block;
+            capacity_ = blockSize;
+            Base::setg(data_, data_ + readOffset, data_ + size_);
+        }
+
+        // Both expect this buffer to be empty
+        void copyFrom(const ArrayStreamBuf& other)
+        {
+            if (other.size_ == 0)
+                return;
+
+            reserve(other.size_);
+            std::memcpy(data_, other.data_, other.size_);
+            size_ = other.size_;
+            Base::setg(data_, data_ + other.position(), data_ + size_);
+        }
+
+        void takeFrom(ArrayStreamBuf& other)
+        {
+            const size_t readOffset = other.position();
+
+            data_     = other.data_;
+            size_     = other.size_;
+            capacity_ = other.capacity_;
+            Base::setg(data_, data_ + readOffset, data_ + size_);
+
+            other.data_     = nullptr;
+            other.size_     = 0;
+            other.capacity_ = 0;
+            other.Base::setg(nullptr, nullptr, nullptr);
+        }
+
+        CharT* data_     = nullptr;
+        size_t size_     = 0;
+        size_t capacity_ = 0;
+        size_t maxSize_  = Const::MaxBuffer;
     };
 
     struct RawBuffer final
@@ -169,12 +320,20 @@ namespace Pistache
     {
         explicit FileBuffer(const std::string& fileName);
 
+        // Takes fd over, which is open on a file of size bytes
+        FileBuffer(int fd, size_t size);
+
+        // Same, for the size bytes of the file that start at offset
+        FileBuffer(int fd, off_t offset, size_t size);
+
         int fd() const;
+        off_t offset() const;
         size_t size() const;
 
     private:
         std::string fileName_;
         int fd_; // regular old file descriptor ("int") even in libevent case
+        off_t offset_ = 0;
         size_t size_;
     };
 
@@ -195,6 +354,10 @@ namespace Pistache
 
         RawBuffer buffer() const;
 
+        // What has been written so far, without copying it. Only valid
+        // until the next write.
+        std::string_view view() const;
+
         void clear();
 
         size_t maxSize() const;
@@ -207,6 +370,10 @@ namespace Pistache
 
         std::vector<char> data_;
         size_t maxSize_ = Const::MaxBuffer;
+
+        // Only allocated on the first write, as a response that is sent in
+        // one go does not go through this buffer
+        size_t initialSize_ = 0;
     };
 
     class StreamCursor
@@ -322,6 +489,16 @@ namespace Pistache
                      CaseSensitivity cs = CaseSensitivity::Insensitive);
     bool match_double(double* val, StreamCursor& cursor);
 
+    /*
+     * Returns a pointer to the first byte of [begin, end) that is equal to
+     * one of the bytes of chars, or end if there is none.
+     *
+     * On x86, the search is vectorized with AVX2 or SSE4.2 when the CPU
+     * supports it (checked once, at runtime), and falls back on a scalar
+     * loop otherwise.
+     */
+    const char* find_any_of(const char* begin, const char* end, std::string_view chars);
+
     void skip_whitespaces(StreamCursor& cursor);
 
 } // namespace Pistache
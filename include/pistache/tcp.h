@@ -34,6 +34,9 @@ namespace Pistache::Tcp
         ReuseAddr   = QuickAck << 1,
         ReusePort   = ReuseAddr << 1,
         CloseOnExec = ReusePort << 1,
+        // Only wake the listener up once a connection has sent data, see
+        // Const::DeferAcceptTimeout. Linux only, ignored elsewhere.
+        DeferAccept = CloseOnExec << 1,
     };
 
     DECLARE_FLAGS_OPERATORS(Options)
@@ -50,6 +53,16 @@ namespace Pistache::Tcp
                              const std::shared_ptr<Tcp::Peer>& peer)
             = 0;
 
+        /*
+         * Lets the handler take the bytes read from peer in place. When
+         * prepareInput() returns a buffer, of at least one byte, up to size
+         * bytes are read right into it and then passed to commitInput(),
+         * rather than read into a buffer of the transport and then handed to
+         * onInput(). By default, it returns nullptr.
+         */
+        virtual char* prepareInput(const std::shared_ptr<Tcp::Peer>& peer, size_t& size);
+        virtual void commitInput(size_t len, const std::shared_ptr<Tcp::Peer>& peer);
+
         virtual void onConnection(const std::shared_ptr<Tcp::Peer>& peer);
         virtual void onDisconnection(const std::shared_ptr<Tcp::Peer>& peer);
 
@@ -0,0 +1,182 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* timer_wheel.h
+
+   A hierarchical timing wheel, keeping a deadline per key.
+
+   Scheduling, rescheduling and cancelling a key are O(1). Advancing the
+   wheel only touches the keys that expire, plus the keys of the coarser
+   levels that get cascaded down as time goes by, which each key goes
+   through at most Levels - 1 times.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace Pistache
+{
+
+    template <typename Key, typename Hash = std::hash<Key>>
+    class TimerWheel
+    {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        // Each level has 2^SlotBits slots, each of them covering 2^SlotBits
+        // slots of the level below. With 4 levels of 64 slots, deadlines up
+        // to 2^24 ticks away are bucketed exactly; farther ones are parked
+        // in the last slot and rescheduled when it is reached.
+        static constexpr unsigned SlotBits = 6;
+        static constexpr unsigned Slots    = 1u << SlotBits;
+        static constexpr unsigned Levels   = 4;
+
+        explicit TimerWheel(std::chrono::milliseconds resolution,
+                            TimePoint start = Clock::now())
+            : resolution_(resolution)
+            , start_(start)
+        { }
+
+        // Sets the deadline of key, whether it was already scheduled or not.
+        // A deadline that has already passed expires with the next tick.
+        void schedule(const Key& key, TimePoint deadline)
+        {
+            uint64_t tick = toTick(deadline);
+            if (tick <= now_)
+                tick = now_ + 1;
+
+            auto it = entries_.find(key);
+            if (it == entries_.end())
+            {
+                auto& slot = slotFor(tick);
+                slot.push_back(key);
+                entries_.emplace(key, Entry { tick, &slot, std::prev(slot.end()) });
+                return;
+            }
+
+            auto& entry = it->second;
+            if (entry.tick == tick)
+                return;
+
+            auto& slot = slotFor(tick);
+            slot.splice(slot.end(), *entry.slot, entry.pos);
+            entry.tick = tick;
+            entry.slot = &slot;
+        }
+
+        void cancel(const Key& key)
+        {
+            auto it = entries_.find(key);
+            if (it == entries_.end())
+                return;
+
+            it->second.slot->erase(it->second.pos);
+            entries_.erase(it);
+        }
+
+        bool contains(const Key& key) const { return entries_.count(key) != 0; }
+        size_t size() const { return entries_.size(); }
+        bool empty() const { return entries_.empty(); }
+
+        /*
+         * Moves the wheel forward to now, removing the keys whose deadline
+         * has been reached and appending them to expired.
+         */
+        void advance(TimePoint now, std::vector<Key>& expired)
+        {
+            const uint64_t target = toTick(now);
+            while (now_ < target)
+            {
+                ++now_;
+
+                // Bring the keys of the coarser levels whose range starts
+                // with this tick down to the finer ones
+                for (unsigned level = 1; level < Levels; ++level)
+                {
+                    if ((now_ & mask(level)) != 0)
+                        break;
+                    cascade(level, (now_ >> (level * SlotBits)) & (Slots - 1));
+                }
+
+                auto& slot = wheel_[0][now_ & (Slots - 1)];
+                for (const auto& key : slot)
+                {
+                    entries_.erase(key);
+                    expired.push_back(key);
+                }
+                slot.clear();
+            }
+        }
+
+    private:
+        struct Entry
+        {
+            uint64_t tick;
+            std::list<Key>* slot;
+            typename std::list<Key>::iterator pos;
+        };
+
+        static constexpr uint64_t mask(unsigned level)
+        {
+            return (uint64_t(1) << (level * SlotBits)) - 1;
+        }
+
+        uint64_t toTick(TimePoint time) const
+        {
+            if (time <= start_)
+                return 0;
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(time - start_);
+            // Round up, so that nothing expires before its deadline
+            return static_cast<uint64_t>((elapsed.count() + resolution_.count() - 1) / resolution_.count());
+        }
+
+        std::list<Key>& slotFor(uint64_t tick)
+        {
+            const uint64_t delta = tick - now_;
+            for (unsigned level = 0; level < Levels; ++level)
+            {
+                if (delta < (uint64_t(1) << ((level + 1) * SlotBits)))
+                    return wheel_[level][(tick >> (level * SlotBits)) & (Slots - 1)];
+            }
+
+            // Too far away: park it in the slot cascaded last before the
+            // wheel wraps around, from where it is bucketed again
+            const unsigned top = Levels - 1;
+            return wheel_[top][((now_ >> (top * SlotBits)) - 1) & (Slots - 1)];
+        }
+
+        void cascade(unsigned level, uint64_t index)
+        {
+            auto keys = std::move(wheel_[level][index]);
+            wheel_[level][index].clear();
+
+            while (!keys.empty())
+            {
+                auto& entry = entries_.find(keys.front())->second;
+                auto& slot  = slotFor(entry.tick);
+                slot.splice(slot.end(), keys, keys.begin());
+                entry.slot = &slot;
+            }
+        }
+
+        std::chrono::milliseconds resolution_;
+        TimePoint start_;
+        uint64_t now_ = 0;
+
+        std::array<std::array<std::list<Key>, Slots>, Levels> wheel_;
+        std::unordered_map<Key, Entry, Hash> entries_;
+    };
+
+} // namespace Pistache
@@ -17,18 +17,24 @@
 #include PST_SYS_RESOURCE_HDR // for PST_RUSAGE + PST_GETRUSAGE
 
 #include <pistache/async.h>
+#include <pistache/log.h>
 #include <pistache/mailbox.h>
 #include <pistache/pist_quote.h>
 #include <pistache/pist_timelog.h>
 #include <pistache/reactor.h>
 #include <pistache/stream.h>
+#include <pistache/timer_pool.h>
 
+#include <atomic>
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace Pistache::Tcp
 {
@@ -54,6 +60,33 @@ namespace Pistache::Tcp
         void handleNewPeer(const std::shared_ptr<Peer>& peer);
         void onReady(const Aio::FdSet& fds) override;
 
+        // Accepts a connection on the listening socket given as argument,
+        // returns nullptr if there was none to accept
+        using Acceptor = std::function<std::shared_ptr<Peer>(Fd)>;
+
+        // Makes the transport poll listenFd itself and take in the peers
+        // returned by acceptor, up to budget each time listenFd is readable,
+        // without going through the Listener thread
+        void setAcceptor(Fd listenFd, Acceptor acceptor,
+                         size_t budget = Const::DefaultAcceptBudget);
+
+        // Bytes read at most from a peer each time it is found readable.
+        // A peer with more to read is then read again once the other peers
+        // ready meanwhile have had their turn, so that a bulk upload does
+        // not hold up the small requests of the same worker. 0 means no
+        // limit. Defaults to Const::DefaultReadBudget.
+        void setReadBudget(size_t budget);
+        size_t readBudget() const;
+
+        // Where failed SSL handshakes are reported, set by the listener
+        void setLogger(PISTACHE_STRING_LOGGER_T logger);
+
+        // Tells a transport that keeps a deadline per peer that the state
+        // the deadline derives from has changed, e.g. a request has come in
+        // or been answered. May be called from any thread. Does nothing
+        // here.
+        virtual void touchPeer(const std::shared_ptr<Peer>& peer);
+
         template <typename Buf>
         Async::Promise<PST_SSIZE_T> asyncWrite(Fd fd, const Buf& buffer,
                                            int flags = 0
@@ -82,6 +115,29 @@ namespace Pistache::Tcp
                 });
         }
 
+        // Takes buffer over instead of copying it
+        Async::Promise<PST_SSIZE_T> asyncWrite(Fd fd, RawBuffer&& buffer,
+                                               int flags = 0
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                               ,
+                                               bool msg_more_style = false
+#endif
+        )
+        {
+            return Async::Promise<PST_SSIZE_T>(
+                [&, this](Async::Deferred<PST_SSIZE_T> deferred) mutable {
+                    BufferHolder holder { std::move(buffer) };
+                    WriteEntry write(std::move(deferred), std::move(holder),
+                                     fd, flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                     ,
+                                     msg_more_style
+#endif
+                    );
+                    writesQueue.push(std::move(write));
+                });
+        }
+
         Async::Promise<PST_RUSAGE> load()
         {
             return Async::Promise<PST_RUSAGE>([this](Async::Deferred<PST_RUSAGE> deferred) {
@@ -104,12 +160,37 @@ namespace Pistache::Tcp
 
         void disarmTimer(Fd fd);
 
+        using TimeoutId = uint64_t;
+
+        /*
+         * Calls callback from the thread of the transport once timeout has
+         * elapsed, unless cancelTimeout() is called first. All the timeouts
+         * of a transport share a single timer, which is only rearmed when a
+         * new deadline comes before all the others: arming and cancelling a
+         * timeout are otherwise done without any system call. The returned
+         * id is never 0.
+         */
+        template <typename Duration>
+        TimeoutId armTimeout(Duration timeout, std::function<void()> callback)
+        {
+            return armTimeoutMs(std::chrono::duration_cast<std::chrono::milliseconds>(timeout),
+                                std::move(callback));
+        }
+
+        // Returns false if the timeout has already fired or been cancelled
+        bool cancelTimeout(TimeoutId id);
+        bool hasTimeout(TimeoutId id) const;
+
         std::shared_ptr<Aio::Handler> clone() const override;
 
         void flush();
 
         std::deque<std::shared_ptr<Peer>> getAllPeer();
 
+        // Peers handed to handleNewPeer() and not yet gone, including those
+        // still queued or in their SSL handshake
+        size_t peerCount() const;
+
 #ifdef _USE_LIBEVENT
         std::shared_ptr<EventMethEpollEquiv> getEventMethEpollEquiv()
         {
@@ -138,10 +219,19 @@ namespace Pistache::Tcp
                 , type(Raw)
             { }
 
+            explicit BufferHolder(RawBuffer&& buffer, off_t offset = 0)
+                : _raw(std::move(buffer))
+                , size_(_raw.size())
+                , offset_(offset)
+                , type(Raw)
+            { }
+
+            // For a file, offsets are positions in the file, and size_ is
+            // where the data to send ends
             explicit BufferHolder(const FileBuffer& buffer, off_t offset = 0)
                 : _fd(buffer.fd())
-                , size_(buffer.size())
-                , offset_(offset)
+                , size_(static_cast<size_t>(buffer.offset()) + buffer.size())
+                , offset_(buffer.offset() + offset)
                 , type(File)
             { }
 
@@ -157,7 +247,7 @@ namespace Pistache::Tcp
                 return _fd;
             }
 
-            RawBuffer raw() const
+            const RawBuffer& raw() const
             {
                 if (!isRaw())
                     throw std::runtime_error("Tried to retrieve raw data of a non-buffer");
@@ -270,11 +360,37 @@ namespace Pistache::Tcp
 
         PollableQueue<PeerEntry> peersQueue;
 
+        // Deadlines of armTimeout(), as a min-heap. Cancelling a timeout only
+        // removes it from timeouts_, its deadline being dropped from the heap
+        // once it reaches the top, or when too many of them pile up.
+        using TimeoutDeadline = std::pair<std::chrono::steady_clock::time_point, TimeoutId>;
+        mutable std::mutex timeoutsMutex_;
+        std::vector<TimeoutDeadline> timeoutDeadlines_;
+        std::unordered_map<TimeoutId, std::function<void()>> timeouts_;
+        TimeoutId nextTimeoutId_ = 1;
+
+        // Armed for the earliest deadline in timeoutDeadlines_
+        std::shared_ptr<TimerPool::Entry> timeoutTimer_;
+        std::chrono::steady_clock::time_point timeoutTimerDeadline_ = std::chrono::steady_clock::time_point::max();
+
+        Fd acceptorFd_ = PS_FD_EMPTY;
+        Acceptor acceptor_;
+        size_t acceptBudget_ = Const::DefaultAcceptBudget;
+
         Async::Deferred<PST_RUSAGE> loadRequest_;
         NotifyFd notifier;
 
+        // Peers that used up their read budget with data left to read, see
+        // setReadBudget(). Only accessed from the reactor thread, which
+        // readyNotifier wakes up to read them again.
+        size_t readBudget_ = Const::DefaultReadBudget;
+        std::deque<std::shared_ptr<Peer>> readyPeers_;
+        NotifyFd readyNotifier;
+
         std::shared_ptr<Tcp::Handler> handler_;
 
+        PISTACHE_STRING_LOGGER_T logger_ = PISTACHE_NULL_STRING_LOGGER;
+
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         int tcp_prot_num_; // TCP protocol num on this host per getprotobyname
 #endif
@@ -282,6 +398,9 @@ namespace Pistache::Tcp
     protected:
         void removePeer(const std::shared_ptr<Peer>& peer);
 
+        // Called by removePeer once peer is out of peers_
+        virtual void forgetPeer(const std::shared_ptr<Peer>& peer);
+
         // Without the use of peers_mutex_ to protect peers_, http_server_test
         // multiple_client_with_requests_to_multithreaded_server fails
         // intermittently (~1 time in 10 - likely highly environment
@@ -292,6 +411,19 @@ namespace Pistache::Tcp
         mutable std::mutex peers_mutex_;
         std::unordered_map<Fd, std::shared_ptr<Peer>> peers_;
 
+        // SSL peers whose handshake is in progress. They are only moved to
+        // peers_, and handed to the handler, once it has completed. Only
+        // accessed from the reactor thread of the transport.
+        std::unordered_map<Fd, std::shared_ptr<Peer>> handshakes_;
+
+        // Peers from handleNewPeer() not yet in peers_, so that the listener
+        // sees them as soon as they are dispatched
+        std::atomic<size_t> pendingPeers_ { 0 };
+
+        // Armed for the earliest deadline in handshakes_
+        std::shared_ptr<TimerPool::Entry> handshakeTimer_;
+        std::chrono::steady_clock::time_point handshakeTimerDeadline_ = std::chrono::steady_clock::time_point::max();
+
     private:
         bool isPeerFd(FdConst fd) const;
         bool isPeerFdNoPeersMutexLock(FdConst fd) const;
@@ -300,6 +432,9 @@ namespace Pistache::Tcp
         bool isTimerFd(Polling::Tag tag) const;
 
         std::shared_ptr<Peer> getPeer(FdConst fd);
+        // Same as getPeer(), but nullptr rather than an exception if fd is
+        // not a peer of this transport
+        std::shared_ptr<Peer> findPeer(FdConst fd) const;
         std::shared_ptr<Peer> getPeer(Polling::Tag tag);
 
         void armTimerMs(Fd fd, std::chrono::milliseconds value,
@@ -307,8 +442,25 @@ namespace Pistache::Tcp
 
         void armTimerMsImpl(TimerEntry entry);
 
-        // This will attempt to drain the write queue for the fd
-        void asyncWriteImpl(Fd fd);
+        TimeoutId armTimeoutMs(std::chrono::milliseconds timeout,
+                               std::function<void()> callback);
+        // timeoutsMutex_ must be held
+        void armTimeoutTimer(std::chrono::steady_clock::time_point deadline);
+        void handleTimeoutTimer();
+
+        // This will attempt to drain the write queue for the fd of peer,
+        // keeping peer flagged for as long as the queue has writes left
+        void asyncWriteImpl(Fd fd, Peer& peer);
+
+#ifndef _USE_LIBEVENT_LIKE_APPLE
+        // Sends the raw entries at the front of wq with a single sendmsg.
+        // Returns false, without having written anything, if the send
+        // failed; the caller then falls back to sending the front entry on
+        // its own, which deals with the error. Unlocks lock on success.
+        bool asyncWriteVectored(Fd fd, Peer& peer, std::deque<WriteEntry>& wq,
+                                std::unique_lock<std::mutex>& lock, bool& stop);
+        bool canWriteVectored(Fd fd) const;
+#endif
 
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         void configureMsgMoreStyle(Fd fd, bool msg_more_style);
@@ -324,12 +476,19 @@ namespace Pistache::Tcp
 
         void handlePeerDisconnection(const std::shared_ptr<Peer>& peer);
         void handleIncoming(const std::shared_ptr<Peer>& peer);
-        void handleWriteQueue(bool flush = false);
+        void handleReadyPeers();
+        void handleWriteQueue();
         void handleTimerQueue();
         void handlePeerQueue();
         void handleNotify();
+        void handleAcceptor();
         void handleTimer(TimerEntry entry);
         void handlePeer(const std::shared_ptr<Peer>& peer);
+        void addPeer(const std::shared_ptr<Peer>& peer);
+        void handleHandshake(const std::shared_ptr<Peer>& peer);
+        void dropHandshake(const std::shared_ptr<Peer>& peer);
+        void armHandshakeTimer(std::chrono::steady_clock::time_point deadline);
+        void handleHandshakeTimer();
     };
 
 } // namespace Pistache::Tcp
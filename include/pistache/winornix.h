@@ -402,6 +402,8 @@ typedef struct in_addr PST_IN_ADDR_T;
 #define PST_SOCK_LISTEN pist_sock_listen
 #define PST_SOCK_SEND pist_sock_send
 #define PST_SOCK_RECV pist_sock_recv
+#define PST_SOCK_SHUTDOWN pist_sock_shutdown
+#define PST_SOCK_SHUT_WR SD_SEND
 
 #define PST_FD_SET_FD_TYPE SOCKET // type to use with FD_SET(fd, ...)
 #define PST_SOCK_SELECT pist_sock_select
@@ -423,6 +425,8 @@ typedef struct in_addr PST_IN_ADDR_T;
 #define PST_SOCK_LISTEN ::listen
 #define PST_SOCK_SEND ::send
 #define PST_SOCK_RECV ::recv
+#define PST_SOCK_SHUTDOWN ::shutdown
+#define PST_SOCK_SHUT_WR SHUT_WR
 
 #define PST_FD_SET_FD_TYPE em_socket_t // type to use with FD_SET(fd, ...)
 #define PST_SOCK_SELECT ::select
@@ -436,8 +440,8 @@ typedef struct PST_POLLFD PST_POLLFD_T;
 #endif
 
 
-// PST_FILE_CLOSE, PST_FILE_OPEN, PST_FILE_READ, PST_FILE_WRITE and
-// PST_FILE_PREAD are for *files*
+// PST_FILE_CLOSE, PST_FILE_OPEN, PST_FILE_READ, PST_FILE_WRITE,
+// PST_FILE_PREAD and PST_FILE_DUP are for *files*
 // For sockets, make sure to use PST_SOCK_xxx macros (above)
 #ifdef _IS_WINDOWS
 // See:
@@ -453,6 +457,7 @@ typedef struct PST_POLLFD PST_POLLFD_T;
 #define PST_FILE_WRITE(__fd, __buf, __count)         \
     ::_write(__fd, __buf, static_cast<unsigned int>(__count))
 #define PST_FILE_PREAD pist_pread
+#define PST_FILE_DUP ::_dup
 
 #define PST_UNLINK ::_unlink
 #define PST_RMDIR ::_rmdir
@@ -465,6 +470,7 @@ typedef int pst_mode_t;
 #define PST_FILE_READ ::read
 #define PST_FILE_WRITE ::write
 #define PST_FILE_PREAD ::pread
+#define PST_FILE_DUP ::dup
 #define PST_UNLINK ::unlink
 #define PST_RMDIR ::rmdir
 
@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* buffer_pool.cc
+
+   Implementation of the buffer pool
+*/
+
+#include <pistache/buffer_pool.h>
+
+#include <array>
+#include <vector>
+
+namespace Pistache
+{
+
+    namespace
+    {
+        constexpr size_t classOf(size_t size)
+        {
+            size_t cls   = 0;
+            size_t block = BufferPool::MinBlockSize;
+            while (block < size)
+            {
+                block <<= 1;
+                ++cls;
+            }
+            return cls;
+        }
+
+        constexpr size_t ClassCount = classOf(BufferPool::MaxPooledBlockSize) + 1;
+
+        struct Cache
+        {
+            Cache() { alive = true; }
+
+            ~Cache()
+            {
+                alive = false;
+                for (auto& blocks : free)
+                {
+                    for (char* block : blocks)
+                        delete[] block;
+                }
+            }
+
+            std::array<std::vector<char*>, ClassCount> free;
+
+            // Blocks released by a thread that is exiting, after its cache
+            // has been destroyed, are freed right away
+            static thread_local bool alive;
+        };
+
+        thread_local bool Cache::alive = false;
+
+        Cache* localCache()
+        {
+            static thread_local Cache cache;
+            return Cache::alive ? &cache : nullptr;
+        }
+    } // namespace
+
+    char* BufferPool::acquire(size_t& size)
+    {
+        const size_t cls = classOf(size);
+        size             = MinBlockSize << cls;
+
+        if (cls < ClassCount)
+        {
+            auto* cache = localCache();
+            if (cache && !cache->free[cls].empty())
+            {
+                char* block = cache->free[cls].back();
+                cache->free[cls].pop_back();
+                return block;
+            }
+        }
+
+        return new char[size];
+    }
+
+    void BufferPool::release(char* block, size_t size)
+    {
+        if (!block)
+            return;
+
+        const size_t cls = classOf(size);
+        if (cls < ClassCount)
+        {
+            auto* cache = localCache();
+            if (cache && cache->free[cls].size() * size < MaxCachedBytes)
+            {
+                cache->free[cls].push_back(block);
+                return;
+            }
+        }
+
+        delete[] block;
+    }
+
+    size_t BufferPool::cached()
+    {
+        auto* cache = localCache();
+        if (!cache)
+            return 0;
+
+        size_t count = 0;
+        for (const auto& blocks : cache->free)
+            count += blocks.size();
+        return count;
+    }
+
+} // namespace Pistache
@@ -12,6 +12,7 @@
 
 #include <pistache/config.h>
 #include <pistache/description.h>
+#include <pistache/file_cache.h>
 #include <pistache/http_header.h>
 
 #include <algorithm>
@@ -408,8 +409,11 @@ namespace Pistache::Rest
     void Swagger::install(Rest::Router& router)
     {
 
-        Route::Handler uiHandler = [this](const Rest::Request& req,
-                                       Http::ResponseWriter response) {
+        // The UI is a handful of static files, asked for over and over
+        auto fileCache = std::make_shared<Http::FileCache>();
+
+        Route::Handler uiHandler = [this, fileCache](const Rest::Request& req,
+                                                     Http::ResponseWriter response) {
             const auto& res = req.resource();
 
             /*
@@ -495,7 +499,7 @@ namespace Pistache::Rest
                 else
                 {
                     auto index = uiDir.join("index.html");
-                    Http::serveFile(response, index);
+                    fileCache->serve(response, req, index);
                 }
                 return Route::Result::Ok;
             }
@@ -509,7 +513,7 @@ namespace Pistache::Rest
                 // In C++20, use std::string::starts_with()
                 if (path.rfind(uiDirectory_, 0) == 0)
                 {
-                    Http::serveFile(response, path);
+                    fileCache->serve(response, req, path);
                     return Route::Result::Ok;
                 }
                 else
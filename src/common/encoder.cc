@@ -0,0 +1,306 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* encoder.cc
+
+   Implementation of the response body encoder
+*/
+
+#include <pistache/encoder.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace Pistache::Http
+{
+
+    namespace
+    {
+        // Contexts a thread keeps at most, per encoding
+        constexpr size_t MaxPooledContexts = 4;
+
+        // Least output room made for the library at once
+        constexpr size_t MinOutputRoom = 64;
+
+        template <typename Context>
+        struct Pool
+        {
+            using Destroy = void (*)(Context*);
+
+            explicit Pool(Destroy destroy)
+                : destroy(destroy)
+            { }
+
+            ~Pool()
+            {
+                for (auto* context : free)
+                    destroy(context);
+            }
+
+            Context* acquire()
+            {
+                if (free.empty())
+                    return nullptr;
+
+                auto* context = free.back();
+                free.pop_back();
+                return context;
+            }
+
+            void release(Context* context)
+            {
+                if (free.size() < MaxPooledContexts)
+                    free.push_back(context);
+                else
+                    destroy(context);
+            }
+
+            Destroy destroy;
+            std::vector<Context*> free;
+        };
+
+        // Contexts released by a thread that is exiting, after its pools
+        // have been destroyed, are freed right away
+        thread_local bool poolsAlive = false;
+
+        struct Pools
+        {
+            Pools() { poolsAlive = true; }
+            ~Pools() { poolsAlive = false; }
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+            static void destroyDeflate(z_stream* stream)
+            {
+                ::deflateEnd(stream);
+                delete stream;
+            }
+
+            Pool<z_stream> deflate { destroyDeflate };
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+            static void destroyZstd(ZSTD_CCtx* context) { ::ZSTD_freeCCtx(context); }
+
+            Pool<ZSTD_CCtx> zstd { destroyZstd };
+#endif
+        };
+
+        // These go unused when no content encoding is enabled
+        [[maybe_unused]] Pools* localPools()
+        {
+            static thread_local Pools pools;
+            return poolsAlive ? &pools : nullptr;
+        }
+
+        // Makes room for size more bytes at the end of out, and returns
+        // where they start
+        [[maybe_unused]] char* grow(std::string& out, size_t size)
+        {
+            const size_t used = out.size();
+            out.resize(used + size);
+            return out.data() + used;
+        }
+    } // namespace
+
+    Encoder::Encoder(Header::Encoding encoding, [[maybe_unused]] int level)
+        : encoding_(encoding)
+    {
+        switch (encoding)
+        {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        case Header::Encoding::Br:
+            brotli_ = ::BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+            if (!brotli_)
+                throw std::runtime_error("BrotliEncoderCreateInstance() failed");
+            ::BrotliEncoderSetParameter(brotli_, BROTLI_PARAM_QUALITY,
+                                        static_cast<uint32_t>(level));
+            ::BrotliEncoderSetParameter(brotli_, BROTLI_PARAM_LGWIN, BROTLI_DEFAULT_WINDOW);
+            ::BrotliEncoderSetParameter(brotli_, BROTLI_PARAM_MODE, BROTLI_DEFAULT_MODE);
+            break;
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        case Header::Encoding::Deflate: {
+            auto* pools = localPools();
+            deflate_    = pools ? pools->deflate.acquire() : nullptr;
+            if (deflate_)
+            {
+                ::deflateReset(deflate_);
+                // Only changes anything if the stream was set up for another
+                // level
+                ::deflateParams(deflate_, level, Z_DEFAULT_STRATEGY);
+                break;
+            }
+
+            // Same format as compress2(), which is the zlib one that HTTP
+            // calls deflate
+            deflate_         = new z_stream {};
+            const int status = ::deflateInit(deflate_, level);
+            if (status != Z_OK)
+            {
+                delete deflate_;
+                throw std::runtime_error(
+                    std::string("deflateInit() failed, returning: ") + std::to_string(status));
+            }
+            break;
+        }
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        case Header::Encoding::Zstd: {
+            auto* pools = localPools();
+            zstd_       = pools ? pools->zstd.acquire() : nullptr;
+            if (zstd_)
+                ::ZSTD_CCtx_reset(zstd_, ZSTD_reset_session_and_parameters);
+            else
+                zstd_ = ::ZSTD_createCCtx();
+
+            if (!zstd_)
+                throw std::runtime_error("ZSTD_createCCtx() failed");
+
+            // 0 is the default level, ZSTD_CLEVEL_DEFAULT
+            ::ZSTD_CCtx_setParameter(zstd_, ZSTD_c_compressionLevel, level);
+            break;
+        }
+#endif
+
+        default:
+            throw std::runtime_error("User requested unknown content encoding.");
+        }
+    }
+
+    Encoder::~Encoder()
+    {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        if (brotli_)
+            ::BrotliEncoderDestroyInstance(brotli_);
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        if (deflate_)
+        {
+            if (auto* pools = localPools())
+                pools->deflate.release(deflate_);
+            else
+                Pools::destroyDeflate(deflate_);
+        }
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        if (zstd_)
+        {
+            if (auto* pools = localPools())
+                pools->zstd.release(zstd_);
+            else
+                Pools::destroyZstd(zstd_);
+        }
+#endif
+    }
+
+    void Encoder::compress([[maybe_unused]] const char* data, [[maybe_unused]] size_t size,
+                           [[maybe_unused]] Mode mode, [[maybe_unused]] std::string& out)
+    {
+        switch (encoding_)
+        {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        case Header::Encoding::Br: {
+            const auto op = mode == Mode::Continue ? BROTLI_OPERATION_PROCESS
+                : mode == Mode::Flush              ? BROTLI_OPERATION_FLUSH
+                                                   : BROTLI_OPERATION_FINISH;
+
+            size_t availIn        = size;
+            const uint8_t* nextIn = reinterpret_cast<const uint8_t*>(data);
+            const size_t room     = std::max(::BrotliEncoderMaxCompressedSize(size), MinOutputRoom);
+
+            for (;;)
+            {
+                size_t availOut  = room;
+                uint8_t* nextOut = reinterpret_cast<uint8_t*>(grow(out, room));
+
+                if (!::BrotliEncoderCompressStream(brotli_, op, &availIn, &nextIn,
+                                                   &availOut, &nextOut, nullptr))
+                    throw std::runtime_error("BrotliEncoderCompressStream() failed");
+
+                out.resize(out.size() - availOut);
+
+                const bool done = op == BROTLI_OPERATION_FINISH
+                    ? ::BrotliEncoderIsFinished(brotli_)
+                    : availIn == 0 && !::BrotliEncoderHasMoreOutput(brotli_);
+                if (done)
+                    break;
+            }
+            break;
+        }
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        case Header::Encoding::Deflate: {
+            const int flush = mode == Mode::Continue ? Z_NO_FLUSH
+                : mode == Mode::Flush                ? Z_SYNC_FLUSH
+                                                     : Z_FINISH;
+
+            deflate_->next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            deflate_->avail_in = static_cast<uInt>(size);
+
+            const size_t room = std::max<size_t>(::deflateBound(deflate_, static_cast<uLong>(size)),
+                                                 MinOutputRoom);
+            for (;;)
+            {
+                deflate_->next_out  = reinterpret_cast<Bytef*>(grow(out, room));
+                deflate_->avail_out = static_cast<uInt>(room);
+
+                const int status = ::deflate(deflate_, flush);
+                if (status == Z_STREAM_ERROR)
+                    throw std::runtime_error("deflate() failed");
+
+                out.resize(out.size() - deflate_->avail_out);
+
+                // Running out of output room is the only reason for deflate()
+                // to stop before it is done
+                if (flush == Z_FINISH ? status == Z_STREAM_END : deflate_->avail_out != 0)
+                    break;
+            }
+            break;
+        }
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        case Header::Encoding::Zstd: {
+            const auto directive = mode == Mode::Continue ? ZSTD_e_continue
+                : mode == Mode::Flush                     ? ZSTD_e_flush
+                                                          : ZSTD_e_end;
+
+            ZSTD_inBuffer input { data, size, 0 };
+            const size_t room = std::max(::ZSTD_compressBound(size), MinOutputRoom);
+
+            for (;;)
+            {
+                ZSTD_outBuffer output { grow(out, room), room, 0 };
+
+                const size_t remaining = ::ZSTD_compressStream2(zstd_, &output, &input, directive);
+                if (::ZSTD_isError(remaining))
+                {
+                    throw std::runtime_error(
+                        std::string("failed to compress data to ZSTD on ZSTD_compressStream2(), returning: ")
+                        + ::ZSTD_getErrorName(remaining));
+                }
+
+                out.resize(out.size() - (room - output.pos));
+
+                if (directive == ZSTD_e_continue ? input.pos == input.size : remaining == 0)
+                    break;
+            }
+            break;
+        }
+#endif
+
+        default:
+            throw std::runtime_error("User requested unknown content encoding.");
+        }
+    }
+
+} // namespace Pistache::Http
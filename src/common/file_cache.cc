@@ -0,0 +1,512 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* file_cache.cc
+
+   Implementation of the static file cache
+*/
+
+#include <pistache/winornix.h>
+
+#include <pistache/encoder.h>
+#include <pistache/file_cache.h>
+#include <pistache/http_header.h>
+
+#include PST_STRERROR_R_HDR
+
+#include <algorithm>
+#include <vector>
+
+#include <fcntl.h> // for file-constants (_O_RDONLY etc.) in Windows
+#include PST_FCNTL_HDR // for function fcntl()
+
+#include PST_MISC_IO_HDR // for _close (io.h / unistd.h)
+#include PIST_FILEFNS_HDR // for "open"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace Pistache::Http
+{
+
+    namespace
+    {
+        PISTACHE_CUSTOM_HEADER(Vary, "Vary")
+
+        struct Sibling
+        {
+            Header::Encoding encoding;
+            const char* suffix;
+        };
+
+        constexpr Sibling Siblings[] = {
+            { Header::Encoding::Br, ".br" },
+            { Header::Encoding::Zstd, ".zst" },
+            { Header::Encoding::Gzip, ".gz" },
+        };
+
+        // Whether pistache can compress with any encoding
+        constexpr bool CanCompress =
+#if defined(PISTACHE_USE_CONTENT_ENCODING_BROTLI) || defined(PISTACHE_USE_CONTENT_ENCODING_ZSTD) || defined(PISTACHE_USE_CONTENT_ENCODING_DEFLATE)
+            true;
+#else
+            false;
+#endif
+
+        // A file is compressed once, so take the time to do it well
+        int compressionLevel(Header::Encoding encoding)
+        {
+            switch (encoding)
+            {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+            case Header::Encoding::Br:
+                return BROTLI_MAX_QUALITY;
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+            case Header::Encoding::Zstd:
+                return 19;
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+            case Header::Encoding::Deflate:
+                return Z_BEST_COMPRESSION;
+#endif
+
+            default:
+                return 0;
+            }
+        }
+
+        struct OpenFile
+        {
+            explicit OpenFile(int fd)
+                : fd(fd)
+            { }
+
+            ~OpenFile() { PST_FILE_CLOSE(fd); }
+
+            OpenFile(const OpenFile&)            = delete;
+            OpenFile& operator=(const OpenFile&) = delete;
+
+            int fd;
+        };
+
+        // The nanoseconds of the modification time, so that a file rewritten
+        // with the same size within the same second is still seen to change
+        long mtimeNsec([[maybe_unused]] const struct stat& sb)
+        {
+#if defined(_IS_WINDOWS)
+            return 0;
+#elif defined(__APPLE__)
+            return static_cast<long>(sb.st_mtimespec.tv_nsec);
+#else
+            return static_cast<long>(sb.st_mtim.tv_nsec);
+#endif
+        }
+
+        // Reads the whole file open as fd, of size bytes
+        std::shared_ptr<const std::string> readAll(int fd, size_t size)
+        {
+            auto content = std::make_shared<std::string>(size, '\0');
+
+            size_t done = 0;
+            while (done < size)
+            {
+                auto res = PST_FILE_READ(fd, content->data() + done, size - done);
+                if (res <= 0)
+                {
+                    if (res == -1 && errno == EINTR)
+                        continue;
+                    return nullptr;
+                }
+                done += static_cast<size_t>(res);
+            }
+
+            return content;
+        }
+    } // namespace
+
+    struct FileCache::Entry
+    {
+        struct Variant
+        {
+            Header::Encoding encoding = Header::Encoding::Identity;
+            size_t size               = 0;
+
+            // Either the content, or the file to send it from
+            std::shared_ptr<const std::string> content;
+            std::shared_ptr<const OpenFile> file;
+        };
+
+        const Variant* find(Header::Encoding encoding) const
+        {
+            for (const auto& variant : variants)
+            {
+                if (variant.encoding == encoding)
+                    return &variant;
+            }
+            return nullptr;
+        }
+
+        const Variant& identity() const { return variants.front(); }
+
+        bool sameFile(const struct stat& sb) const
+        {
+            return sb.st_ino == ino && sb.st_dev == dev && sb.st_mtime == mtime
+                && mtimeNsec(sb) == mtimeNs && static_cast<size_t>(sb.st_size) == identity().size;
+        }
+
+        decltype(std::declval<struct stat>().st_ino) ino {};
+        decltype(std::declval<struct stat>().st_dev) dev {};
+        decltype(std::declval<struct stat>().st_mtime) mtime {};
+        long mtimeNs = 0;
+
+        // Of the file itself, the ones of its variants add their encoding
+        std::string etag;
+
+        Mime::MediaType mime;
+
+        // The file itself comes first
+        std::vector<Variant> variants;
+
+        // Bytes held in memory
+        size_t memory = 0;
+
+        std::chrono::steady_clock::time_point checkedAt;
+    };
+
+    FileCache::FileCache() = default;
+
+    FileCache::~FileCache() = default;
+
+    FileCache& FileCache::maxMemoryFileSize(size_t size)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        maxMemoryFileSize_ = size;
+        return *this;
+    }
+
+    FileCache& FileCache::maxMemoryBytes(size_t size)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        maxMemoryBytes_ = size;
+        return *this;
+    }
+
+    FileCache& FileCache::maxEntries(size_t count)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        maxEntries_ = count;
+        while (lru_.size() > maxEntries_)
+            evict();
+        return *this;
+    }
+
+    size_t FileCache::size() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return entries_.size();
+    }
+
+    size_t FileCache::memoryBytes() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return memoryBytes_;
+    }
+
+    void FileCache::clear()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        entries_.clear();
+        lru_.clear();
+        memoryBytes_ = 0;
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::lookup(const std::string& fileName)
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        std::shared_ptr<const Entry> cached;
+        size_t memoryLeft  = 0;
+        size_t maxFileSize = 0;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            auto it = entries_.find(fileName);
+            if (it != entries_.end())
+            {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                cached = it->second->second;
+                if (now - cached->checkedAt < revalidateAfter_)
+                    return cached;
+            }
+
+            memoryLeft  = maxMemoryBytes_ > memoryBytes_ ? maxMemoryBytes_ - memoryBytes_ : 0;
+            maxFileSize = maxMemoryFileSize_;
+        }
+
+        int fd = PST_FILE_OPEN(fileName.c_str(), PST_O_RDONLY);
+        if (fd == -1)
+        {
+            const int openErrno = errno;
+
+            PST_DECL_SE_ERR_P_EXTRA;
+            std::string str_error(PST_STRERROR_R_ERRNO);
+
+            if (cached)
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+                auto it = entries_.find(fileName);
+                if (it != entries_.end() && it->second->second == cached)
+                {
+                    memoryBytes_ -= cached->memory;
+                    auto slot = it->second;
+                    entries_.erase(it);
+                    lru_.erase(slot);
+                }
+            }
+
+            if (openErrno == ENOENT)
+                throw HttpError(Http::Code::Not_Found, std::move(str_error));
+            throw HttpError(Http::Code::Internal_Server_Error, std::move(str_error));
+        }
+
+        auto file = std::make_shared<const OpenFile>(fd);
+
+        struct stat sb;
+        if (::fstat(fd, &sb) == -1)
+            throw HttpError(Code::Internal_Server_Error, "");
+
+        if ((sb.st_mode & S_IFMT) != S_IFREG)
+            throw HttpError(Code::Not_Found, "Not a regular file");
+
+        if (cached && cached->sameFile(sb))
+        {
+            auto refreshed       = std::make_shared<Entry>(*cached);
+            refreshed->checkedAt = now;
+            store(fileName, refreshed);
+            return refreshed;
+        }
+
+        auto entry       = std::make_shared<Entry>();
+        entry->ino       = sb.st_ino;
+        entry->dev       = sb.st_dev;
+        entry->mtime     = sb.st_mtime;
+        entry->mtimeNs   = mtimeNsec(sb);
+        entry->etag      = Private::fileETag(sb.st_mtime, static_cast<size_t>(sb.st_size));
+        entry->mime      = Mime::MediaType::fromFile(fileName.c_str());
+        entry->checkedAt = now;
+
+        // Holds file, or its content if it is small enough
+        auto addVariant = [&](Header::Encoding encoding,
+                              std::shared_ptr<const OpenFile> variantFile, size_t size) {
+            Entry::Variant variant;
+            variant.encoding = encoding;
+            variant.size     = size;
+
+            if (size <= maxFileSize && size <= memoryLeft)
+                variant.content = readAll(variantFile->fd, size);
+
+            if (variant.content)
+            {
+                memoryLeft -= size;
+                entry->memory += size;
+            }
+            else
+            {
+                variant.file = std::move(variantFile);
+            }
+
+            entry->variants.push_back(std::move(variant));
+        };
+
+        addVariant(Header::Encoding::Identity, std::move(file), static_cast<size_t>(sb.st_size));
+
+        for (const auto& sibling : Siblings)
+        {
+            const std::string siblingName = fileName + sibling.suffix;
+
+            int siblingFd = PST_FILE_OPEN(siblingName.c_str(), PST_O_RDONLY);
+            if (siblingFd == -1)
+                continue;
+
+            auto siblingFile = std::make_shared<const OpenFile>(siblingFd);
+
+            struct stat siblingSb;
+            if (::fstat(siblingFd, &siblingSb) == -1 || (siblingSb.st_mode & S_IFMT) != S_IFREG)
+                continue;
+
+            addVariant(sibling.encoding, std::move(siblingFile),
+                       static_cast<size_t>(siblingSb.st_size));
+        }
+
+        store(fileName, entry);
+        return entry;
+    }
+
+    std::shared_ptr<const FileCache::Entry>
+    FileCache::withVariant(const std::string& fileName,
+                           const std::shared_ptr<const Entry>& entry,
+                           Header::Encoding encoding)
+    {
+        const auto& identity = entry->identity();
+
+        // The compressed variant is held in memory too, and is smaller than
+        // the file itself when it is worth keeping
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (memoryBytes_ + identity.size > maxMemoryBytes_)
+                return entry;
+        }
+
+        std::string compressed;
+        try
+        {
+            Encoder encoder(encoding, compressionLevel(encoding));
+            encoder.compress(identity.content->data(), identity.content->size(),
+                             Encoder::Mode::Finish, compressed);
+        }
+        catch (const std::exception& e)
+        {
+            PS_LOG_WARNING_ARGS("Could not compress %s: %s", fileName.c_str(), e.what());
+            return entry;
+        }
+
+        auto updated = std::make_shared<Entry>(*entry);
+
+        Entry::Variant variant;
+        variant.encoding = encoding;
+        variant.size     = compressed.size();
+        variant.content  = std::make_shared<const std::string>(std::move(compressed));
+
+        updated->memory += variant.size;
+        updated->variants.push_back(std::move(variant));
+
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            // The file changed meanwhile
+            auto it = entries_.find(fileName);
+            if (it == entries_.end() || it->second->second != entry)
+                return updated;
+
+            // Served this once, but there is no room to keep it
+            if (memoryBytes_ - entry->memory + updated->memory > maxMemoryBytes_)
+                return updated;
+        }
+
+        store(fileName, updated);
+        return updated;
+    }
+
+    void FileCache::store(const std::string& fileName, std::shared_ptr<const Entry> entry)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto it = entries_.find(fileName);
+        if (it != entries_.end())
+        {
+            memoryBytes_ -= it->second->second->memory;
+            memoryBytes_ += entry->memory;
+            it->second->second = std::move(entry);
+            return;
+        }
+
+        if (maxEntries_ == 0)
+            return;
+
+        while (lru_.size() >= maxEntries_)
+            evict();
+
+        memoryBytes_ += entry->memory;
+        lru_.emplace_front(fileName, std::move(entry));
+        entries_.emplace(lru_.front().first, lru_.begin());
+    }
+
+    void FileCache::evict()
+    {
+        auto& victim = lru_.back();
+        memoryBytes_ -= victim.second->memory;
+        entries_.erase(victim.first);
+        lru_.pop_back();
+    }
+
+    Async::Promise<PST_SSIZE_T> FileCache::serve(ResponseWriter& writer, const Request& request,
+                                                 const std::string& fileName,
+                                                 const Mime::MediaType& contentType)
+    {
+        auto entry = lookup(fileName);
+
+        const bool inMemory = entry->identity().content != nullptr;
+
+        // Pick the first encoding the client prefers that there is, or can
+        // be, a variant for, as long as it is smaller than the file itself
+        auto encoding = Header::Encoding::Identity;
+        if (auto accept = request.headers().tryGet<Header::AcceptEncoding>())
+        {
+            for (const auto& accepted : accept->encodings())
+            {
+                if (accepted.second == 0)
+                    continue;
+                if (accepted.first == Header::Encoding::Identity)
+                    break;
+
+                if (!entry->find(accepted.first) && inMemory
+                    && Header::encodingSupported(accepted.first))
+                    entry = withVariant(fileName, entry, accepted.first);
+
+                const auto* variant = entry->find(accepted.first);
+                if (variant && variant->size < entry->identity().size)
+                {
+                    encoding = accepted.first;
+                    break;
+                }
+            }
+        }
+
+        const auto& variant = *entry->find(encoding);
+
+        auto& headers = writer.headers();
+        const auto& mime = contentType.isValid() ? contentType : entry->mime;
+        if (mime.isValid())
+        {
+            auto ct = headers.tryGet<Header::ContentType>();
+            if (ct)
+                ct->setMime(mime);
+            else
+                headers.add<Header::ContentType>(mime);
+        }
+
+        if (encoding != Header::Encoding::Identity)
+            headers.add<Header::ContentEncoding>(encoding);
+
+        if (entry->variants.size() > 1 || (inMemory && CanCompress))
+            headers.add<Vary>("Accept-Encoding");
+
+        ResponseWriter::FileContent file;
+        file.size         = variant.size;
+        file.lastModified = std::chrono::system_clock::from_time_t(entry->mtime);
+        file.etag         = entry->etag;
+        if (encoding != Header::Encoding::Identity)
+            file.etag.append("-").append(Header::encodingString(encoding));
+
+        if (variant.content)
+        {
+            file.data = variant.content->data();
+        }
+        else
+        {
+            // The transport closes the descriptor it is given once done,
+            // while the cache keeps its own
+            file.fd = PST_FILE_DUP(variant.file->fd);
+            if (file.fd == -1)
+                throw HttpError(Code::Internal_Server_Error, "Could not duplicate file descriptor");
+        }
+
+        return writer.putFileOnWire(&request, std::move(file));
+    }
+
+} // namespace Pistache::Http
@@ -13,6 +13,8 @@
 #include <pistache/winornix.h>
 
 #include <pistache/config.h>
+#include <pistache/date_wrapper.h>
+#include <pistache/encoder.h>
 #include <pistache/eventmeth.h>
 #include <pistache/http.h>
 #include <pistache/http_header.h>
@@ -22,14 +24,21 @@
 
 #include PST_STRERROR_R_HDR
 
+#include <algorithm>
+#include <array>
+#include <cctype>
 #include <charconv>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <limits>
+#include <optional>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include <fcntl.h> // for file-constants (_O_RDONLY etc.) in Windows
@@ -130,7 +139,228 @@ namespace Pistache::Http
 #undef PST_OUT
         }
 
-        using HttpMethods = std::unordered_map<std::string, Method>;
+        // Reason phrases, indexed by status code
+        constexpr size_t StatusCodeCount = 600;
+
+        constexpr std::array<std::string_view, StatusCodeCount> reasonPhrases = [] {
+            std::array<std::string_view, StatusCodeCount> phrases {};
+#define CODE(value, _, str) phrases[value] = str;
+            STATUS_CODES
+#undef CODE
+            return phrases;
+        }();
+
+        constexpr std::string_view CRLF = "\r\n";
+
+        // Appends everything that is written to it to a string, so that
+        // headers and cookies can be serialized in place
+        class StringAppendBuf : public std::streambuf
+        {
+        public:
+            explicit StringAppendBuf(std::string& out)
+                : out_(out)
+            { }
+
+        protected:
+            int_type overflow(int_type ch) override
+            {
+                if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                    out_.push_back(traits_type::to_char_type(ch));
+                return traits_type::not_eof(ch);
+            }
+
+            std::streamsize xsputn(const char_type* s, std::streamsize n) override
+            {
+                out_.append(s, static_cast<size_t>(n));
+                return n;
+            }
+
+        private:
+            std::string& out_;
+        };
+
+        void appendNumber(std::string& out, size_t value)
+        {
+            char digits[20];
+            auto res = std::to_chars(std::begin(digits), std::end(digits), value);
+            out.append(digits, res.ptr);
+        }
+
+        void appendStatusLine(std::string& out, Version version, Code code)
+        {
+            const auto value = static_cast<size_t>(code);
+
+            out.append(versionString(version));
+            out.push_back(' ');
+            appendNumber(out, value);
+            out.push_back(' ');
+            if (value < StatusCodeCount)
+                out.append(reasonPhrases[value]);
+            out.append(CRLF);
+        }
+
+        // Appends a two digits number, with a leading zero
+        char* formatTwoDigits(char* out, unsigned value)
+        {
+            *out++ = static_cast<char>('0' + value / 10);
+            *out++ = static_cast<char>('0' + value % 10);
+            return out;
+        }
+
+        /*
+         * The Date header line, as in "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n",
+         * of the responses sent by the calling thread. It is formatted again
+         * the first time it is needed in a new second, and only then.
+         */
+        std::string_view dateLine()
+        {
+            static constexpr std::string_view Days[]   = { "Sun", "Mon", "Tue", "Wed",
+                                                           "Thu", "Fri", "Sat" };
+            static constexpr std::string_view Months[] = { "Jan", "Feb", "Mar", "Apr",
+                                                           "May", "Jun", "Jul", "Aug",
+                                                           "Sep", "Oct", "Nov", "Dec" };
+
+            struct Cache
+            {
+                std::chrono::system_clock::rep second = -1;
+                std::array<char, 64> text;
+                size_t size = 0;
+            };
+            thread_local Cache cache;
+
+            const auto now = date::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+            const auto second = now.time_since_epoch().count();
+            if (second == cache.second)
+                return std::string_view(cache.text.data(), cache.size);
+
+            const auto days = date::floor<date::days>(now);
+            const date::year_month_day ymd { days };
+            const date::weekday weekday { days };
+            const auto time = static_cast<unsigned>((now - days).count());
+
+            auto append = [](char* out, std::string_view text) {
+                return std::copy(text.begin(), text.end(), out);
+            };
+
+            char* out = cache.text.data();
+            out       = append(out, "Date: ");
+            out       = append(out, Days[weekday.c_encoding()]);
+            out       = append(out, ", ");
+            out       = formatTwoDigits(out, static_cast<unsigned>(ymd.day()));
+            *out++    = ' ';
+            out       = append(out, Months[static_cast<unsigned>(ymd.month()) - 1]);
+            *out++    = ' ';
+            out       = std::to_chars(out, out + 4, static_cast<int>(ymd.year())).ptr;
+            *out++    = ' ';
+            out       = formatTwoDigits(out, time / 3600);
+            *out++    = ':';
+            out       = formatTwoDigits(out, time / 60 % 60);
+            *out++    = ':';
+            out       = formatTwoDigits(out, time % 60);
+            out       = append(out, " GMT");
+            out       = append(out, CRLF);
+
+            cache.second = second;
+            cache.size   = static_cast<size_t>(out - cache.text.data());
+            return std::string_view(cache.text.data(), cache.size);
+        }
+
+        // Passes the headers the handler adds to every response, and that
+        // headers does not have yet, to append, piece by piece
+        template <typename Append>
+        void defaultHeaders(const Handler* handler, const Header::Collection& headers,
+                            Append&& append)
+        {
+            if (!handler)
+                return;
+
+            if (handler->getDateHeader() && !headers.has<Header::Date>())
+                append(dateLine());
+
+            const auto& server = handler->getServerHeader();
+            if (!server.empty() && !headers.has<Header::Server>())
+            {
+                append(std::string_view(Header::Server::Name));
+                append(std::string_view(": "));
+                append(std::string_view(server));
+                append(CRLF);
+            }
+        }
+
+        /*
+         * Appends a whole response head to out, from the status line to the
+         * empty line that ends it. The ostream the headers and the cookies
+         * need to write themselves is only built if there are any.
+         */
+        void appendHead(std::string& out, Version version, Code code,
+                        const Handler* handler, const Header::Collection& headers,
+                        const CookieJar* cookies, size_t contentLength)
+        {
+            appendStatusLine(out, version, code);
+
+            defaultHeaders(handler, headers,
+                           [&](std::string_view piece) { out.append(piece); });
+
+            StringAppendBuf buf(out);
+            std::optional<std::ostream> os;
+            auto stream = [&]() -> std::ostream& {
+                if (!os)
+                    os.emplace(&buf);
+                return *os;
+            };
+
+            headers.forEach([&](const Header::Header& header) {
+                out.append(header.name());
+                out.append(": ");
+                header.write(stream());
+                out.append(CRLF);
+            });
+
+            if (cookies)
+            {
+                // The iterator's operator* returns a copy of the cookie
+                for (auto it = cookies->begin(); it != cookies->end(); ++it)
+                {
+                    out.append("Set-Cookie: ");
+                    stream() << *it.operator->();
+                    out.append(CRLF);
+                }
+            }
+
+            // A 304 has no body, and the Content-Length it may carry is the
+            // one of the representation it stands for (RFC 9110, 8.6)
+            if (code != Code::Not_Modified)
+            {
+                out.append(Header::ContentLength::Name);
+                out.append(": ");
+                appendNumber(out, contentLength);
+                out.append(CRLF);
+            }
+
+            out.append(CRLF);
+        }
+
+        // Enough for the status line and a few headers
+        constexpr size_t HeadSizeHint = 256;
+
+        // Output of the encoders of the calling thread, reused from a
+        // response to the next one unless it grew larger than that
+        constexpr size_t MaxKeptCompressionBuffer = 1024 * 1024;
+
+        std::string& compressionBuffer()
+        {
+            thread_local std::string buffer;
+            buffer.clear();
+            return buffer;
+        }
+
+        void trimCompressionBuffer(std::string& buffer)
+        {
+            if (buffer.capacity() > MaxKeptCompressionBuffer)
+                std::string().swap(buffer);
+        }
+
+        using HttpMethods = std::unordered_map<std::string_view, Method>;
 
         const HttpMethods httpMethods = {
 #define METHOD(repr, str) { str, Method::repr },
@@ -138,11 +368,580 @@ namespace Pistache::Http
 #undef METHOD
         };
 
+        /*
+         * Looks for the CRLF terminating the line that starts at the cursor.
+         * scanPos is how many bytes past the cursor a previous call has
+         * already looked for the terminator; the search resumes from there,
+         * so that a line arriving in several pieces is only scanned once.
+         * The cursor itself is not moved. Being relative to the cursor,
+         * scanPos stays right when the buffer drops the bytes before it.
+         */
+        bool nextLine(StreamCursor& cursor, size_t& scanPos, std::string_view& line)
+        {
+            const char* begin      = cursor.offset();
+            const size_t remaining = cursor.remaining();
+
+            size_t from = std::min(scanPos, remaining);
+            while (from < remaining)
+            {
+                const auto* cr = static_cast<const char*>(
+                    std::memchr(begin + from, CR, remaining - from));
+                if (cr == nullptr)
+                {
+                    from = remaining;
+                    break;
+                }
+
+                const auto idx = static_cast<size_t>(cr - begin);
+                if (idx + 1 == remaining)
+                {
+                    // Trailing CR, the LF might come with the next read
+                    from = idx;
+                    break;
+                }
+
+                if (begin[idx + 1] == LF)
+                {
+                    line    = std::string_view(begin, idx);
+                    scanPos = 0;
+                    return true;
+                }
+
+                from = idx + 1;
+            }
+
+            scanPos = from;
+            return false;
+        }
+
+        // Vectorized std::string_view::find_first_of(), see find_any_of()
+        size_t findAnyOf(std::string_view line, size_t pos, std::string_view chars)
+        {
+            const char* end   = line.data() + line.size();
+            const char* found = find_any_of(line.data() + pos, end, chars);
+            return found == end ? std::string_view::npos
+                                : static_cast<size_t>(found - line.data());
+        }
+
+        PISTACHE_CUSTOM_HEADER(AcceptRanges, "Accept-Ranges")
+        PISTACHE_CUSTOM_HEADER(ContentRange, "Content-Range")
+
+        // Beyond that many ranges in a Range header, the header is ignored
+        // and the whole file is sent
+        constexpr size_t MaxRanges = 16;
+
+        std::string_view trimOws(std::string_view str)
+        {
+            while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                str.remove_prefix(1);
+            while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                str.remove_suffix(1);
+            return str;
+        }
+
+        // A number too large for size_t is taken as the largest one, which
+        // is as good as infinite for a file position
+        bool parsePosition(std::string_view str, size_t& value)
+        {
+            if (str.empty())
+                return false;
+
+            const auto* end = str.data() + str.size();
+            const auto res  = std::from_chars(str.data(), end, value);
+            if (res.ptr != end)
+                return false;
+            if (res.ec == std::errc::result_out_of_range)
+                value = std::numeric_limits<size_t>::max();
+            return res.ec == std::errc() || res.ec == std::errc::result_out_of_range;
+        }
+
+        struct ByteRange
+        {
+            size_t first;
+            size_t length;
+        };
+
+        /*
+         * Parses the value of a Range header asking for bytes of a
+         * representation of size bytes (RFC 9110, 14.1.2). Returns false if
+         * the header is to be ignored; otherwise, ranges holds the
+         * satisfiable ones, sorted and coalesced, and may be empty.
+         */
+        bool parseRanges(std::string_view value, size_t size, std::vector<ByteRange>& ranges)
+        {
+            constexpr std::string_view Unit = "bytes=";
+
+            value = trimOws(value);
+            if (value.size() < Unit.size() || !Header::LowercaseEqual {}(value.substr(0, Unit.size()), Unit))
+                return false;
+            value.remove_prefix(Unit.size());
+
+            size_t specs = 0;
+            while (!value.empty())
+            {
+                const auto comma = value.find(',');
+                const auto spec  = trimOws(value.substr(0, comma));
+                value            = comma == std::string_view::npos ? std::string_view()
+                                                                   : value.substr(comma + 1);
+
+                // Empty list elements are allowed
+                if (spec.empty())
+                    continue;
+
+                if (++specs > MaxRanges)
+                    return false;
+
+                const auto dash = spec.find('-');
+                if (dash == std::string_view::npos)
+                    return false;
+
+                const auto firstStr = spec.substr(0, dash);
+                const auto lastStr  = spec.substr(dash + 1);
+
+                if (firstStr.empty())
+                {
+                    // The last suffix bytes
+                    size_t suffix = 0;
+                    if (!parsePosition(lastStr, suffix))
+                        return false;
+                    if (suffix > 0 && size > 0)
+                    {
+                        const size_t length = std::min(suffix, size);
+                        ranges.push_back({ size - length, length });
+                    }
+                    continue;
+                }
+
+                size_t first = 0;
+                size_t last  = std::numeric_limits<size_t>::max();
+                if (!parsePosition(firstStr, first))
+                    return false;
+                if (!lastStr.empty() && (!parsePosition(lastStr, last) || last < first))
+                    return false;
+
+                if (first < size)
+                    ranges.push_back({ first, std::min(last, size - 1) - first + 1 });
+            }
+
+            if (specs == 0)
+                return false;
+
+            std::sort(ranges.begin(), ranges.end(),
+                      [](const ByteRange& a, const ByteRange& b) { return a.first < b.first; });
+
+            // Overlapping or adjacent ranges are sent as one
+            size_t kept = 0;
+            for (size_t i = 1; i < ranges.size(); ++i)
+            {
+                auto& prev       = ranges[kept];
+                const size_t end = prev.first + prev.length;
+                if (ranges[i].first <= end)
+                    prev.length = std::max(end, ranges[i].first + ranges[i].length) - prev.first;
+                else
+                    ranges[++kept] = ranges[i];
+            }
+            if (!ranges.empty())
+                ranges.resize(kept + 1);
+
+            return true;
+        }
+
+        /*
+         * Whether the list of entity tags of an If-None-Match or If-Range
+         * header holds the opaque tag etagc. A weak tag on either side only
+         * matches with the weak comparison (RFC 9110, 8.8.3.2).
+         */
+        bool etagListMatches(std::string_view list, std::string_view etagc, bool etagWeak,
+                             bool weakComparison)
+        {
+            list = trimOws(list);
+            if (list == "*")
+                return true;
+
+            size_t pos = 0;
+            while (pos < list.size())
+            {
+                if (list[pos] == ',' || list[pos] == ' ' || list[pos] == '\t')
+                {
+                    ++pos;
+                    continue;
+                }
+
+                bool weak = false;
+                if (list.compare(pos, 2, "W/") == 0)
+                {
+                    weak = true;
+                    pos += 2;
+                }
+
+                if (pos >= list.size() || list[pos] != '"')
+                    return false;
+
+                const auto end = list.find('"', pos + 1);
+                if (end == std::string_view::npos)
+                    return false;
+
+                if (list.substr(pos + 1, end - pos - 1) == etagc
+                    && (weakComparison || (!weak && !etagWeak)))
+                    return true;
+
+                pos = end + 1;
+            }
+
+            return false;
+        }
+
+        std::optional<std::chrono::system_clock::time_point> parseHttpDate(const std::string& str)
+        {
+            try
+            {
+                return FullDate::fromString(str).date();
+            }
+            catch (const std::exception&)
+            {
+                return std::nullopt;
+            }
+        }
+
+        /*
+         * Evaluates the preconditions of request, and its Range header, for
+         * a representation of size bytes (RFC 9110, 13.2.2). Returns the
+         * status to answer with, Ok to send it all, or Partial_Content to
+         * send the ranges.
+         */
+        Code evaluateFileRequest(const Request& request, const Header::ETag& etag,
+                                 std::chrono::system_clock::time_point lastModified,
+                                 size_t size, std::vector<ByteRange>& ranges)
+        {
+            using std::chrono::seconds;
+            using std::chrono::time_point_cast;
+
+            const auto& headers   = request.headers();
+            const bool getOrHead  = request.method() == Method::Get
+                || request.method() == Method::Head;
+            const auto modifiedAt = time_point_cast<seconds>(lastModified);
+
+            if (auto ifNoneMatch = headers.tryGetRaw("If-None-Match"))
+            {
+                if (etagListMatches(ifNoneMatch->value(), etag.etagc(), etag.isWeak(), true))
+                    return getOrHead ? Code::Not_Modified : Code::Precondition_Failed;
+            }
+            else if (auto ifModifiedSince = headers.tryGetRaw("If-Modified-Since"); ifModifiedSince && getOrHead)
+            {
+                auto since = parseHttpDate(ifModifiedSince->value());
+                if (since && modifiedAt <= *since)
+                    return Code::Not_Modified;
+            }
+
+            if (request.method() != Method::Get)
+                return Code::Ok;
+
+            auto range = headers.tryGetRaw("Range");
+            if (!range)
+                return Code::Ok;
+
+            // The ranges are only sent if the file is still the one that
+            // the client has the other parts of
+            if (auto ifRange = headers.tryGetRaw("If-Range"))
+            {
+                const auto& value = ifRange->value();
+                if (value.empty())
+                    return Code::Ok;
+
+                if (value.front() == '"' || value.compare(0, 2, "W/") == 0)
+                {
+                    if (!etagListMatches(value, etag.etagc(), etag.isWeak(), false))
+                        return Code::Ok;
+                }
+                else
+                {
+                    auto date = parseHttpDate(value);
+                    if (!date || *date != modifiedAt)
+                        return Code::Ok;
+                }
+            }
+
+            if (!parseRanges(range->value(), size, ranges))
+                return Code::Ok;
+
+            return ranges.empty() ? Code::Requested_Range_Not_Satisfiable : Code::Partial_Content;
+        }
+
+        std::string contentRange(size_t first, size_t length, size_t size)
+        {
+            std::string out("bytes ");
+            appendNumber(out, first);
+            out.push_back('-');
+            appendNumber(out, first + length - 1);
+            out.push_back('/');
+            appendNumber(out, size);
+            return out;
+        }
+
+        std::string multipartBoundary()
+        {
+            thread_local std::mt19937_64 engine { std::random_device {}() };
+
+            static constexpr char Digits[] = "0123456789abcdef";
+
+            std::string boundary("pistache-");
+            auto value = engine();
+            for (int i = 0; i < 16; ++i, value >>= 4)
+                boundary.push_back(Digits[value & 0xF]);
+            return boundary;
+        }
+
+        // A part of the body of a file response: bytes of the response
+        // itself, then length bytes of the file from first
+        struct FilePiece
+        {
+            std::string prefix;
+            size_t first;
+            size_t length;
+        };
+
+        struct FileBody
+        {
+            std::vector<FilePiece> pieces;
+
+            // Sent after the last piece
+            std::string trailer;
+
+            size_t size() const
+            {
+                size_t total = trailer.size();
+                for (const auto& piece : pieces)
+                    total += piece.prefix.size() + piece.length;
+                return total;
+            }
+        };
+
+        Async::Promise<PST_SSIZE_T> writeMore(Tcp::Transport* transport, Fd sockFd,
+                                              std::string&& data)
+        {
+            const auto size = data.size();
+            return transport->asyncWrite(sockFd, RawBuffer(std::move(data), size),
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                         0, // MSG_MORE unsupported in macos sendmsg
+                                            // Instead, we set TCP_NOPUSH via
+                                            // setsockopt (see "man tcp").
+                                         true // use msg_more_style
+#else
+                                         MSG_MORE
+#endif
+            );
+        }
+
+        /*
+         * Sends the pieces of body from index on, then its trailer. The
+         * transport closes the descriptor of each piece once sent, so all
+         * of them but the last one get a duplicate of fd. Resolves to the
+         * number of bytes of body.
+         */
+        Async::Promise<PST_SSIZE_T> sendFileBody(Tcp::Transport* transport, Fd sockFd, int fd,
+                                                 std::shared_ptr<FileBody> body, size_t index)
+        {
+            using Next = std::function<Async::Promise<PST_SSIZE_T>(PST_SSIZE_T)>;
+            using Fail = std::function<void(std::exception_ptr&)>;
+
+            auto closeFd = [fd](std::exception_ptr& eptr) {
+                PST_FILE_CLOSE(fd);
+                return Async::Promise<PST_SSIZE_T>::rejected(eptr);
+            };
+
+            return writeMore(transport, sockFd, std::move(body->pieces[index].prefix))
+                .then<Next, Fail>(
+                    [=](PST_SSIZE_T) {
+                        const bool last    = index + 1 == body->pieces.size();
+                        const auto& piece  = body->pieces[index];
+                        const int pieceFd = last ? fd : PST_FILE_DUP(fd);
+                        if (pieceFd == -1)
+                        {
+                            PST_FILE_CLOSE(fd);
+                            return Async::Promise<PST_SSIZE_T>::rejected(
+                                Error("Could not duplicate file descriptor"));
+                        }
+
+                        auto sent = transport->asyncWrite(
+                            sockFd, FileBuffer(pieceFd, static_cast<off_t>(piece.first), piece.length));
+
+                        if (!last)
+                        {
+                            return sent.then<Next, Fail>(
+                                [=](PST_SSIZE_T) {
+                                    return sendFileBody(transport, sockFd, fd, body, index + 1);
+                                },
+                                closeFd);
+                        }
+
+                        const auto size = static_cast<PST_SSIZE_T>(body->size());
+                        if (body->trailer.empty())
+                            return sent.then([size](PST_SSIZE_T) { return size; }, Async::Throw);
+
+                        return sent.then<Next, Fail>(
+                            [=](PST_SSIZE_T) {
+                                const auto trailerSize = body->trailer.size();
+                                return transport
+                                    ->asyncWrite(sockFd, RawBuffer(std::move(body->trailer), trailerSize))
+                                    .then([size](PST_SSIZE_T) { return size; }, Async::Throw);
+                            },
+                            Async::Throw);
+                    },
+                    closeFd);
+        }
+
+        // Whether headers end the connection along with the response they
+        // go with
+        bool closesConnection(const Header::Collection& headers)
+        {
+            auto connection = headers.tryGet<Header::Connection>();
+            return connection && connection->control() == ConnectionControl::Close;
+        }
+
+        // Half-closes the connection of peer once sent is done with, whether
+        // it went out or not
+        void shutdownAfter(Async::Promise<PST_SSIZE_T>& sent, std::weak_ptr<Tcp::Peer> peer)
+        {
+            auto shutdown = [peer = std::move(peer)]() {
+                if (auto sp = peer.lock())
+                    sp->shutdownWrite();
+            };
+
+            sent.then([shutdown](PST_SSIZE_T) { shutdown(); },
+                      [shutdown](std::exception_ptr&) { shutdown(); });
+        }
+
     } // namespace
 
     namespace Private
     {
 
+        std::string fileETag(time_t mtime, size_t size)
+        {
+            char buf[2 * sizeof(uint64_t) + 2 * sizeof(size_t) + 2];
+            auto res   = std::to_chars(buf, buf + sizeof(buf), static_cast<uint64_t>(mtime), 16);
+            *res.ptr++ = '-';
+            res        = std::to_chars(res.ptr, buf + sizeof(buf), size, 16);
+            return std::string(buf, res.ptr);
+        }
+
+        uint64_t ResponseSequencer::open()
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            return next_++;
+        }
+
+        void ResponseSequencer::close(uint64_t response)
+        {
+            std::unique_lock<std::mutex> guard(mutex_);
+
+            // Otherwise the thread draining, or the one closing the
+            // responses before, picks it up
+            if (response != current_ || draining_)
+            {
+                closed_.insert(response);
+                return;
+            }
+
+            ++current_;
+            draining_ = true;
+            drain(guard);
+        }
+
+        bool ResponseSequencer::enter(uint64_t response)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (response != current_ || draining_)
+                return false;
+
+            draining_ = true;
+            return true;
+        }
+
+        void ResponseSequencer::leave()
+        {
+            std::unique_lock<std::mutex> guard(mutex_);
+            drain(guard);
+        }
+
+        Async::Promise<PST_SSIZE_T> ResponseSequencer::hold(uint64_t response, Write write)
+        {
+            std::unique_lock<std::mutex> guard(mutex_);
+            if (response < current_)
+            {
+                return Async::Promise<PST_SSIZE_T>::rejected(
+                    Error("Response already sent"));
+            }
+
+            Async::Promise<bool> turn([&](Async::Deferred<bool> deferred) {
+                held_[response].push_back(std::move(deferred));
+            });
+            auto sent = turn.then(
+                [write = std::move(write)](bool) {
+                    // Thrown from here, it would reach whoever drains
+                    try
+                    {
+                        return write();
+                    }
+                    catch (const std::runtime_error& e)
+                    {
+                        return Async::Promise<PST_SSIZE_T>::rejected(e);
+                    }
+                },
+                Async::Throw);
+
+            // The response may have come to its turn in the meantime
+            if (!draining_)
+            {
+                draining_ = true;
+                drain(guard);
+            }
+
+            return sent;
+        }
+
+        void ResponseSequencer::drain(std::unique_lock<std::mutex>& guard)
+        {
+            for (;;)
+            {
+                auto it = held_.find(current_);
+                if (it != held_.end())
+                {
+                    auto due = std::move(it->second);
+                    held_.erase(it);
+
+                    // The writes may answer more requests, from this thread
+                    guard.unlock();
+                    for (auto& deferred : due)
+                        deferred.resolve(true);
+                    guard.lock();
+                    continue;
+                }
+
+                auto closed = closed_.find(current_);
+                if (closed == closed_.end())
+                    break;
+
+                closed_.erase(closed);
+                ++current_;
+            }
+
+            draining_ = false;
+        }
+
+        ResponseTurn::ResponseTurn(std::shared_ptr<ResponseSequencer> sequencer)
+            : sequencer_(std::move(sequencer))
+            , response_(sequencer_->open())
+        { }
+
+        ResponseTurn::~ResponseTurn() { close(); }
+
+        void ResponseTurn::close()
+        {
+            if (!closed_.exchange(true, std::memory_order_acq_rel))
+                sequencer_->close(response_);
+        }
+
         Step::Step(Message* request)
             : message(request)
         { }
@@ -154,15 +953,14 @@ namespace Pistache::Http
 
         State RequestLineStep::apply(StreamCursor& cursor)
         {
-            StreamCursor::Revert revert(cursor);
+            std::string_view line;
+            if (!nextLine(cursor, scanPos, line))
+                return State::Again;
 
             auto* request = static_cast<Request*>(message);
 
-            StreamCursor::Token methodToken(cursor);
-            if (!match_until(' ', cursor))
-                return State::Again;
-
-            auto it = httpMethods.find(methodToken.text());
+            const auto methodEnd = line.find(' ');
+            auto it              = httpMethods.find(line.substr(0, methodEnd));
             if (it != httpMethods.end())
             {
                 request->method_ = it->second;
@@ -172,88 +970,63 @@ namespace Pistache::Http
                 raise("Unknown HTTP request method");
             }
 
-            int n;
-
-            if (cursor.eof())
-                return State::Again;
-            else if ((n = cursor.current()) != ' ')
+            if (methodEnd == std::string_view::npos)
                 raise("Malformed HTTP request after Method, expected SP");
 
-            if (!cursor.advance(1))
-                return State::Again;
-
-            StreamCursor::Token resToken(cursor);
-            while ((n = cursor.current()) != '?' && n != ' ')
-                if (!cursor.advance(1))
-                    return State::Again;
+            size_t pos             = methodEnd + 1;
+            const auto resourceEnd = findAnyOf(line, pos, "? ");
+            if (resourceEnd == std::string_view::npos)
+                raise("Malformed HTTP request after resource, expected SP");
 
-            request->resource_ = resToken.text();
+            request->resource_ = std::string(line.substr(pos, resourceEnd - pos));
+            pos                = resourceEnd;
 
             // Query parameters of the Uri
-            if (n == '?')
+            if (line[pos] == '?')
             {
-                if (!cursor.advance(1))
-                    return State::Again;
-
-                while ((n = cursor.current()) != ' ')
+                ++pos;
+                while (pos < line.size() && line[pos] != ' ')
                 {
-                    StreamCursor::Token keyToken(cursor);
-                    if (!match_until({ '=', ' ', '&' }, cursor))
-                        return State::Again;
+                    const auto keyEnd = findAnyOf(line, pos, "= &");
+                    if (keyEnd == std::string_view::npos)
+                        break;
 
-                    std::string key = keyToken.text();
+                    std::string key(line.substr(pos, keyEnd - pos));
+                    pos = keyEnd;
 
-                    auto c = cursor.current();
-                    if (c == ' ')
+                    if (line[pos] == '=')
                     {
-                        request->query_.add(std::move(key), "");
+                        ++pos;
+                        const auto valueEnd = findAnyOf(line, pos, " &");
+                        if (valueEnd == std::string_view::npos)
+                            break;
+
+                        request->query_.add(std::move(key),
+                                            std::string(line.substr(pos, valueEnd - pos)));
+                        pos = valueEnd;
                     }
-                    else if (c == '&')
+                    else
                     {
                         request->query_.add(std::move(key), "");
-                        if (!cursor.advance(1))
-                            return State::Again;
                     }
-                    else if (c == '=')
-                    {
-                        if (!cursor.advance(1))
-                            return State::Again;
-
-                        StreamCursor::Token valueToken(cursor);
-                        if (!match_until({ ' ', '&' }, cursor))
-                            return State::Again;
 
-                        std::string value = valueToken.text();
-                        request->query_.add(std::move(key), std::move(value));
-                        if (cursor.current() == '&')
-                        {
-                            if (!cursor.advance(1))
-                                return State::Again;
-                        }
-                    }
+                    if (line[pos] == '&')
+                        ++pos;
                 }
+
+                if (pos >= line.size())
+                    raise("Malformed HTTP request after query, expected SP");
             }
 
             // @Todo: Fragment
 
-            // SP
-            if (!cursor.advance(1))
-                return State::Again;
-
-            // HTTP-Version
-            StreamCursor::Token versionToken(cursor);
-
-            while (!cursor.eol())
-                if (!cursor.advance(1))
-                    return State::Again;
-
-            const char* ver   = versionToken.rawText();
-            const size_t size = versionToken.size();
-            if (strncmp(ver, "HTTP/1.0", size) == 0)
+            // SP, then HTTP-Version
+            const auto version = line.substr(pos + 1);
+            if (version == "HTTP/1.0")
             {
                 request->version_ = Version::Http10;
             }
-            else if (strncmp(ver, "HTTP/1.1", size) == 0)
+            else if (version == "HTTP/1.1")
             {
                 request->version_ = Version::Http11;
             }
@@ -262,24 +1035,25 @@ namespace Pistache::Http
                 raise("Encountered invalid HTTP version");
             }
 
-            if (!cursor.advance(2))
-                return State::Again;
-
-            revert.ignore();
+            cursor.advance(line.size() + 2);
             return State::Next;
         }
 
         State ResponseLineStep::apply(StreamCursor& cursor)
         {
-            StreamCursor::Revert revert(cursor);
+            std::string_view line;
+            if (!nextLine(cursor, scanPos, line))
+                return State::Again;
 
             auto* response = static_cast<Response*>(message);
 
-            if (match_raw("HTTP/1.1", strlen("HTTP/1.1"), cursor))
+            constexpr std::string_view http11 = "HTTP/1.1";
+            constexpr std::string_view http10 = "HTTP/1.0";
+            if (line.substr(0, http11.size()) == http11)
             {
                 // response->version = Version::Http11;
             }
-            else if (match_raw("HTTP/1.0", strlen("HTTP/1.0"), cursor))
+            else if (line.substr(0, http10.size()) == http10)
             {
             }
             else
@@ -287,85 +1061,84 @@ namespace Pistache::Http
                 raise("Encountered invalid HTTP version");
             }
 
-            int n;
             // SP
-            if ((n = cursor.current()) != StreamCursor::Eof && n != ' ')
+            if (line.size() == http11.size() || line[http11.size()] != ' ')
                 raise("Expected SPACE after http version");
-            if (!cursor.advance(1))
-                return State::Again;
 
-            StreamCursor::Token codeToken(cursor);
-            if (!match_until(' ', cursor))
-                return State::Again;
+            const auto codeToken = line.substr(http11.size() + 1,
+                                               line.find(' ', http11.size() + 1) - http11.size() - 1);
 
             int code               = 0;
-            const char* beg        = codeToken.rawText();
-            const char* end        = codeToken.rawText() + codeToken.size();
+            const char* beg        = codeToken.data();
+            const char* end        = codeToken.data() + codeToken.size();
             const auto parseResult = std::from_chars(beg, end, code);
 
-            if (parseResult.ec != std::errc {} || *parseResult.ptr != ' ')
-                raise("Failed to parse return code");
-            response->code_ = static_cast<Http::Code>(code);
-
-            if (!cursor.advance(1))
-                return State::Again;
-
-            while (!cursor.eol() && !cursor.eof())
-            {
-                cursor.advance(1);
-            }
-
-            if (!cursor.advance(2))
-                return State::Again;
+            if (parseResult.ec != std::errc {} || parseResult.ptr != end)
+                raise("Failed to parse return code");
+            response->code_ = static_cast<Http::Code>(code);
 
-            revert.ignore();
+            cursor.advance(line.size() + 2);
             return State::Next;
         }
 
         State HeadersStep::apply(StreamCursor& cursor)
         {
-            StreamCursor::Revert revert(cursor);
-
-            while (!cursor.eol())
+            // Every complete header line is committed to the message as soon
+            // as it is found, so that a header block arriving in several
+            // pieces is never parsed twice
+            std::string_view line;
+            while (nextLine(cursor, scanPos, line))
             {
-                StreamCursor::Revert headerRevert(cursor);
-
-                // Read the header name
-                size_t start = cursor;
+                cursor.advance(line.size() + 2);
 
-                while (cursor.current() != ':')
-                    if (!cursor.advance(1))
-                        return State::Again;
+                // Empty line, end of the header block
+                if (line.empty())
+                    return State::Next;
 
-                // Skip the ':'
-                if (!cursor.advance(1))
-                    return State::Again;
+                const auto colon = line.find(':');
+                if (colon == std::string_view::npos)
+                    raise("Malformed header, expected ':'");
 
-                std::string name = std::string(cursor.offset(start), cursor.diff(start) - 1);
+                const auto nameView = line.substr(0, colon);
 
                 // Ignore spaces
-                while (cursor.current() == ' ')
-                    if (!cursor.advance(1))
-                        return State::Again;
+                size_t start = colon + 1;
+                while (start < line.size() && line[start] == ' ')
+                    ++start;
 
                 // Read the header value
-                start = cursor;
-                while (!cursor.eol())
+                const char* value      = line.data() + start;
+                const size_t valueSize = line.size() - start;
+
+                if (lazy)
                 {
-                    if (!cursor.advance(1))
-                        return State::Again;
+                    // Cookies are always parsed, everything else is only
+                    // parsed if and when it is looked up
+                    if (Header::LowercaseEqual {}(nameView, "cookie"))
+                    {
+                        message->cookies_.removeAllCookies();
+                        message->cookies_.addFromRaw(value, valueSize);
+                    }
+                    else if (Header::LowercaseEqual {}(nameView, "set-cookie"))
+                    {
+                        message->cookies_.add(Cookie::fromRaw(value, valueSize));
+                    }
+
+                    message->headers_.addLazy(nameView, std::string_view(value, valueSize));
+                    continue;
                 }
 
+                std::string name(nameView);
+
                 if (Header::LowercaseEqualStatic(name, "cookie"))
                 {
                     message->cookies_.removeAllCookies(); // removing existing cookies before
                                                           // re-adding them.
-                    message->cookies_.addFromRaw(cursor.offset(start), cursor.diff(start));
+                    message->cookies_.addFromRaw(value, valueSize);
                 }
                 else if (Header::LowercaseEqualStatic(name, "set-cookie"))
                 {
-                    message->cookies_.add(
-                        Cookie::fromRaw(cursor.offset(start), cursor.diff(start)));
+                    message->cookies_.add(Cookie::fromRaw(value, valueSize));
                 }
 
                 // If the header is registered with the Registry, add its strongly
@@ -373,27 +1146,16 @@ namespace Pistache::Http
                 else if (Header::Registry::instance().isRegistered(name))
                 {
                     std::shared_ptr<Header::Header> header = Header::Registry::instance().makeHeader(name);
-                    header->parseRaw(cursor.offset(start), cursor.diff(start));
+                    header->parseRaw(value, valueSize);
                     message->headers_.add(header);
                 }
 
                 // But also preserve a raw header version too, regardless of whether
                 //  its type was known to the Registry...
-                std::string value(cursor.offset(start), cursor.diff(start));
-                message->headers_.addRaw(Header::Raw(std::move(name), std::move(value)));
-
-                // CRLF
-                if (!cursor.advance(2))
-                    return State::Again;
-
-                headerRevert.ignore();
+                message->headers_.addRaw(Header::Raw(std::move(name), std::string(value, valueSize)));
             }
 
-            if (!cursor.advance(2))
-                return State::Again;
-
-            revert.ignore();
-            return State::Next;
+            return State::Again;
         }
 
         State BodyStep::apply(StreamCursor& cursor)
@@ -464,52 +1226,57 @@ namespace Pistache::Http
         {
             if (size == -1)
             {
-                StreamCursor::Revert revert(cursor);
-                StreamCursor::Token chunkSize(cursor);
-
-                while (!cursor.eol())
-                    if (!cursor.advance(1))
-                        return Incomplete;
+                std::string_view chunkSize;
+                if (!nextLine(cursor, scanPos, chunkSize))
+                    return Incomplete;
 
-                const char* raw { chunkSize.rawText() };
-                const auto* end { chunkSize.rawText() + chunkSize.size() };
+                const char* raw { chunkSize.data() };
+                const auto* end { chunkSize.data() + chunkSize.size() };
 
                 size_t sz              = 0;
                 const auto parseResult = std::from_chars(raw, end, sz, 16);
 
-                if (parseResult.ec != std::errc {} || *parseResult.ptr != '\r')
+                if (parseResult.ec != std::errc {} || parseResult.ptr != end)
                     throw std::runtime_error("Invalid chunk size");
 
                 // CRLF
-                if (!cursor.advance(2))
-                    return Incomplete;
-
-                revert.ignore();
+                cursor.advance(chunkSize.size() + 2);
 
                 size                      = sz;
                 alreadyAppendedChunkBytes = 0;
             }
 
             if (size == 0)
-                return Final;
+            {
+                // Last chunk, skip the trailer section up to the final CRLF
+                std::string_view trailer;
+                while (nextLine(cursor, scanPos, trailer))
+                {
+                    cursor.advance(trailer.size() + 2);
+                    if (trailer.empty())
+                        return Final;
+                }
+                return Incomplete;
+            }
 
-            message->body_.reserve(size);
-            StreamCursor::Token chunkData(cursor);
-            const PST_SSIZE_T available = cursor.remaining();
+            message->body_.reserve(message->body_.size() + size - alreadyAppendedChunkBytes);
 
-            if (available + alreadyAppendedChunkBytes < size + 2)
+            // Chunk data, possibly split over several reads
+            const PST_SSIZE_T missing = size - alreadyAppendedChunkBytes;
+            if (missing > 0)
             {
+                const PST_SSIZE_T available = std::min(
+                    static_cast<PST_SSIZE_T>(cursor.remaining()), missing);
+                message->body_.append(cursor.offset(), available);
                 cursor.advance(available);
-                message->body_.append(chunkData.rawText(), available);
                 alreadyAppendedChunkBytes += available;
-                return Incomplete;
+                if (available < missing)
+                    return Incomplete;
             }
-            cursor.advance(size - alreadyAppendedChunkBytes);
 
             // trailing EOL
-            cursor.advance(2);
-
-            message->body_.append(chunkData.rawText(), size - alreadyAppendedChunkBytes);
+            if (!cursor.advance(2))
+                return Incomplete;
 
             return Complete;
         }
@@ -578,11 +1345,55 @@ namespace Pistache::Http
             return buffer.feed(data, len);
         }
 
+        size_t ParserBase::feedSome(const char* data, size_t len)
+        {
+            len = std::min(len, buffer.room());
+            if (len > 0)
+                buffer.feed(data, len);
+            return len;
+        }
+
+        char* ParserBase::prepare(size_t& len)
+        {
+            char* data = buffer.prepare(len);
+            return len > 0 ? data : nullptr;
+        }
+
+        void ParserBase::commit(size_t len)
+        {
+            buffer.commit(len);
+        }
+
         void ParserBase::reset()
         {
             buffer.reset();
             cursor.reset();
+            messageStart = 0;
+
+            resetMessage();
+        }
+
+        void ParserBase::nextMessage()
+        {
+            messageStart = buffer.position();
 
+            resetMessage();
+        }
+
+        bool ParserBase::compact()
+        {
+            if (messageStart == 0)
+                return false;
+
+            buffer.compact(messageStart);
+            messageStart = 0;
+            return true;
+        }
+
+        void ParserBase::resetMessage()
+        {
+            for (auto& step : allSteps)
+                step->reset();
             currentStep = 0;
         }
 
@@ -591,6 +1402,15 @@ namespace Pistache::Http
             return allSteps[currentStep].get();
         }
 
+        void ParserBase::setLazyHeaders(bool lazy)
+        {
+            for (auto& step : allSteps)
+            {
+                if (step->id() == HeadersStep::Id)
+                    static_cast<HeadersStep*>(step.get())->setLazy(lazy);
+            }
+        }
+
     } // namespace Private
 
     namespace Uri
@@ -714,16 +1534,24 @@ namespace Pistache::Http
         , buf_(std::move(other.buf_))
         , transport_(other.transport_)
         , timeout_(std::move(other.timeout_))
+        , turn_(std::move(other.turn_))
+        , encoder_(std::move(other.encoder_))
+        , plain_(std::move(other.plain_))
     { }
 
     ResponseStream::ResponseStream(Message&& other, std::weak_ptr<Tcp::Peer> peer,
-                                   Tcp::Transport* transport, Timeout timeout,
-                                   size_t streamSize, size_t maxResponseSize)
+                                   Tcp::Transport* transport, const Handler* handler,
+                                   Timeout timeout, std::shared_ptr<Private::ResponseTurn> turn,
+                                   size_t streamSize, size_t maxResponseSize,
+                                   std::unique_ptr<Encoder> encoder)
         : response_(std::move(other))
         , peer_(std::move(peer))
         , buf_(streamSize, maxResponseSize)
         , transport_(transport)
         , timeout_(std::move(timeout))
+        , turn_(std::move(turn))
+        , encoder_(std::move(encoder))
+        , plain_(streamSize, maxResponseSize)
     {
         if (!writeStatusLine(response_.version(), response_.code(), buf_))
             throw Error("Response exceeded buffer size");
@@ -736,13 +1564,9 @@ namespace Pistache::Http
         if (writeHeaders(response_.headers(), buf_))
         {
             std::ostream os(&buf_);
-            /* @Todo @Major:
-             * Correctly handle non-keep alive requests
-             * Do not put Keep-Alive if version == Http::11 and request.keepAlive ==
-             * true
-             */
-            // writeHeader<Header::Connection>(os, ConnectionControl::KeepAlive);
-            // if (!os) throw Error("Response exceeded buffer size");
+            defaultHeaders(handler, response_.headers(), [&](std::string_view piece) {
+                os.write(piece.data(), static_cast<std::streamsize>(piece.size()));
+            });
             writeHeader<Header::TransferEncoding>(os, Header::Encoding::Chunked);
             if (!os)
                 throw Error("Response exceeded buffer size");
@@ -757,12 +1581,24 @@ namespace Pistache::Http
         buf_       = std::move(other.buf_);
         transport_ = other.transport_;
         timeout_   = std::move(other.timeout_);
+        turn_      = std::move(other.turn_);
+        encoder_   = std::move(other.encoder_);
+        plain_     = std::move(other.plain_);
 
         return *this;
     }
 
+    ResponseStream::~ResponseStream() = default;
+
     std::streamsize ResponseStream::write(const char* data, std::streamsize sz)
     {
+        if (encoder_)
+        {
+            std::ostream os(&plain_);
+            os.write(data, sz);
+            return sz;
+        }
+
         std::ostream os(&buf_);
         os << std::hex << sz << crlf;
         os.write(data, sz);
@@ -780,18 +1616,59 @@ namespace Pistache::Http
         return peer_.lock();
     }
 
+    Async::Promise<PST_SSIZE_T> ResponseStream::putOnWire(RawBuffer buffer)
+    {
+        auto send = [transport = transport_, fd = peer()->fd(),
+                     buffer = std::move(buffer)]() mutable {
+            return transport->asyncWrite(fd, std::move(buffer));
+        };
+
+        if (!turn_)
+            return send();
+
+        return turn_->write(std::move(send));
+    }
+
+    void ResponseStream::encodeChunk(bool last)
+    {
+        const auto plain = plain_.view();
+        if (plain.empty() && !last)
+            return;
+
+        auto& compressed = compressionBuffer();
+        encoder_->compress(plain.data(), plain.size(),
+                           last ? Encoder::Mode::Finish : Encoder::Mode::Flush,
+                           compressed);
+        plain_.clear();
+
+        // An empty chunk would end the response
+        if (!compressed.empty())
+        {
+            std::ostream os(&buf_);
+            os << std::hex << compressed.size() << crlf;
+            os.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+            os << crlf;
+
+            if (!os)
+                throw Error("Response exceeded buffer size");
+        }
+
+        trimCompressionBuffer(compressed);
+    }
+
     void ResponseStream::flush()
     {
-        timeout_.disarm();
-        auto buf = buf_.buffer();
+        if (encoder_)
+            encodeChunk(false);
 
-        auto fd = peer()->fd();
-        transport_->asyncWrite(fd, buf);
+        timeout_.disarm();
+        putOnWire(buf_.buffer());
 
         // Calling transport_->flush from here is unnecessary - we already
         // placed the write on the transport's writesQueue with the call to
-        // asyncWrite directly above; the transport will send just as soon as
-        // the fd becomes writable.
+        // putOnWire directly above, or it gets there once the responses
+        // before this one have; the transport will send just as soon as the
+        // fd becomes writable.
         //
         // Calling transport_->flush is also dangerous - writesQueue is
         // supposed to be single consumer queue, but calling flush here
@@ -807,6 +1684,12 @@ namespace Pistache::Http
 
     void ResponseStream::ends()
     {
+        if (encoder_)
+        {
+            encodeChunk(true);
+            encoder_.reset();
+        }
+
         std::ostream os(&buf_);
         os << "0" << crlf;
         os << crlf;
@@ -816,7 +1699,22 @@ namespace Pistache::Http
             throw Error("Response exceeded buffer size");
         }
 
-        flush();
+        if (!closesConnection(response_.headers()))
+        {
+            flush();
+        }
+        else
+        {
+            timeout_.disarm();
+            auto sent = putOnWire(buf_.buffer());
+            shutdownAfter(sent, peer_);
+
+            buf_.clear();
+        }
+
+        // The next response can follow
+        if (turn_)
+            turn_->close();
     }
 
     ResponseWriter::ResponseWriter(ResponseWriter&& other)
@@ -825,23 +1723,28 @@ namespace Pistache::Http
         , buf_(std::move(other.buf_))
         , transport_(other.transport_)
         , timeout_(std::move(other.timeout_))
+        , turn_(std::move(other.turn_))
     { }
 
     ResponseWriter::ResponseWriter(Http::Version version, Tcp::Transport* transport,
-                                   Handler* handler, std::weak_ptr<Tcp::Peer> peer)
+                                   Handler* handler, std::weak_ptr<Tcp::Peer> peer,
+                                   std::shared_ptr<Private::ResponseTurn> turn)
         : response_(version)
         , peer_(peer)
         , buf_(DefaultStreamSize, handler->getMaxResponseSize())
         , transport_(transport)
-        , timeout_(transport, version, handler, peer)
+        , timeout_(transport, version, handler, peer, turn)
+        , turn_(std::move(turn))
     { }
 
+    // The clone answers the same request, and shares its turn
     ResponseWriter::ResponseWriter(const ResponseWriter& other)
         : response_(other.response_)
         , peer_(other.peer_)
         , buf_(DefaultStreamSize, other.buf_.maxSize())
         , transport_(other.transport_)
         , timeout_(other.timeout_)
+        , turn_(other.turn_)
     { }
 
     void ResponseWriter::setMime(const Mime::MediaType& mime)
@@ -888,6 +1791,8 @@ namespace Pistache::Http
         {
             auto curPeer = peer_.lock();
             curPeer->setIdle(true); // change peer state to idle
+            if (transport_)
+                transport_->touchPeer(curPeer); // now on the keep-alive timeout
 
             // It will result in double free
             // Http::Handler::getParser(curPeer)->reset(); // reset the timeout time
@@ -908,118 +1813,48 @@ namespace Pistache::Http
             }
         }
 
-        // Compress data, if necessary, before sending over wire to user...
-        switch (contentEncoding_)
-        {
+        // No compression requested. Send uncompressed data to client...
+        if (contentEncoding_ == Http::Header::Encoding::Identity)
+            return putOnWire(data, size);
 
-#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
-        // User requested Brotli compression...
-        case Http::Header::Encoding::Br: {
-
-            // Location for size of compressed buffer, initially set to upper
-            //  bound on the data after its been compressed...
-            size_t compressedSize = ::BrotliEncoderMaxCompressedSize(size);
-
-            // Failed...
-            if (compressedSize == 0)
-                throw std::runtime_error("BrotliEncoderMaxCompressedSize() failed");
-
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(compressedSize);
-
-            // Compress data. The encoder expects compressedSize to initially be
-            //  the size of the output buffer. After it completes writing it
-            //  will update its value to reflect actual size used...
-            const auto compressionStatus = ::BrotliEncoderCompress(
-                contentEncodingBrotliLevel_,
-                BROTLI_DEFAULT_WINDOW,
-                BROTLI_DEFAULT_MODE,
-                size,
-                reinterpret_cast<const uint8_t*>(data),
-                &compressedSize,
-                reinterpret_cast<uint8_t*>(compressedData.get()));
-
-            // Failed...
-            if (compressionStatus != BROTLI_TRUE)
-                throw std::runtime_error("BrotliEncoderCompress() failed");
-
-            // Notify client to expect Brotli compressed response...
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Br);
-
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compressedSize);
-        }
-#endif
+        // Compress data before sending over wire to user. Throws if the
+        //  encoding is not supported...
+        Encoder encoder(contentEncoding_, compressionLevel());
 
-#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        auto& compressed = compressionBuffer();
+        encoder.compress(data, size, Encoder::Mode::Finish, compressed);
 
-        case Http::Header::Encoding::Zstd: {
-            size_t estimated_size = ZSTD_compressBound(size);
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(estimated_size);
+        // Notify client to expect compressed response...
+        headers().add<Http::Header::ContentEncoding>(contentEncoding_);
 
-            auto compress_size = ZSTD_compress(reinterpret_cast<void*>(compressedData.get()), estimated_size,
-                                               data, size, contentEncodingZstdLevel_);
-            if (ZSTD_isError(compress_size))
-            {
-                throw std::runtime_error(
-                    std::string("failed to compress data to ZSTD on ZSTD_compress(), returning: ") + std::to_string(compress_size));
-            }
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Zstd);
+        // Send compressed data back to client. putOnWire() copies it, so that
+        //  the buffer can be reused right away...
+        auto promise = putOnWire(compressed.data(), compressed.size());
+        trimCompressionBuffer(compressed);
+        return promise;
+    }
 
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compress_size);
-        }
+    int ResponseWriter::compressionLevel() const
+    {
+        switch (contentEncoding_)
+        {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        case Http::Header::Encoding::Br:
+            return contentEncodingBrotliLevel_;
+#endif
 
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        case Http::Header::Encoding::Zstd:
+            return contentEncodingZstdLevel_;
 #endif
 
 #ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
-        // User requested deflate compression...
-        case Http::Header::Encoding::Deflate: {
-
-            // Compute upper bound on size of expected compressed data. This
-            //  will be updated by compress2()...
-            uLongf compressedSize = static_cast<uLongf>(::compressBound(static_cast<uLong>(size)));
-
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(compressedSize);
-
-            // Compress user data at requested level...
-            const auto compressionStatus = ::compress2(
-                reinterpret_cast<unsigned char*>(compressedData.get()),
-                &compressedSize,
-                reinterpret_cast<const unsigned char*>(data),
-                static_cast<uLong>(size),
-                contentEncodingDeflateLevel_);
-
-            // Failed...
-            if (compressionStatus != Z_OK)
-                throw std::runtime_error(
-                    std::string("compress2() failed, returning: ") + std::to_string(compressionStatus));
-
-            // Notify client to expect deflate compressed response...
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Deflate);
-
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compressedSize);
-        }
+        case Http::Header::Encoding::Deflate:
+            return contentEncodingDeflateLevel_;
 #endif
-        // No compression requested. Send uncompressed data to client...
-        case Http::Header::Encoding::Identity:
-            return putOnWire(data, size);
 
-        // Unknown...
         default:
-            throw std::runtime_error("User requested unknown content encoding.");
+            return 0;
         }
     }
 
@@ -1027,8 +1862,16 @@ namespace Pistache::Http
     {
         response_.code_ = code;
 
-        return ResponseStream(std::move(response_), peer_, transport_,
-                              std::move(timeout_), streamSize, buf_.maxSize());
+        std::unique_ptr<Encoder> encoder;
+        if (contentEncoding_ != Http::Header::Encoding::Identity)
+        {
+            encoder = std::make_unique<Encoder>(contentEncoding_, compressionLevel());
+            headers().add<Http::Header::ContentEncoding>(contentEncoding_);
+        }
+
+        return ResponseStream(std::move(response_), peer_, transport_, handler(),
+                              std::move(timeout_), std::move(turn_), streamSize,
+                              buf_.maxSize(), std::move(encoder));
     }
 
     const CookieJar& ResponseWriter::cookies() const { return response_.cookies(); }
@@ -1068,57 +1911,63 @@ namespace Pistache::Http
     {
         try
         {
-            std::ostream os(&buf_);
+            // Whatever has been written to rdbuf() goes out first
+            const auto pending = buf_.view();
+
+            // Checked before anything is copied, and again once the size of
+            // the head is known
+            if (pending.size() + len > buf_.maxSize())
+            {
+                return Async::Promise<PST_SSIZE_T>::rejected(
+                    Error("Response exceeded buffer size"));
+            }
 
-#define PST_OUT(...)                                      \
-    do                                                    \
-    {                                                     \
-        __VA_ARGS__;                                      \
-        if (!os)                                          \
-        {                                                 \
-            return Async::Promise<PST_SSIZE_T>::rejected( \
-                Error("Response exceeded buffer size"));  \
-        }                                                 \
-    } while (0);
-
-            PST_OUT(writeStatusLine(response_.version(), response_.code(), buf_));
-            PST_OUT(writeHeaders(response_.headers(), buf_));
-            PST_OUT(writeCookies(response_.cookies(), buf_));
-
-            /* @Todo @Major:
-             * Correctly handle non-keep alive requests
-             * Do not put Keep-Alive if version == Http::11 and request.keepAlive ==
-             * true
-             */
-            // PST_OUT(writeHeader<Header::Connection>(os, ConnectionControl::KeepAlive));
-            PST_OUT(writeHeader<Header::ContentLength>(os, len));
+            std::string out;
+            out.reserve(pending.size() + HeadSizeHint + len);
+            out.append(pending);
 
-            PST_OUT(os << crlf);
+            appendHead(out, response_.version(), response_.code(), handler(),
+                       response_.headers(), &response_.cookies(), len);
 
-            if (len > 0)
+            if (out.size() + len > buf_.maxSize())
             {
-                PST_OUT(os.write(data, len));
+                return Async::Promise<PST_SSIZE_T>::rejected(
+                    Error("Response exceeded buffer size"));
             }
 
-            auto buffer = buf_.buffer();
-            sent_bytes_ += buffer.size();
+            if (len > 0)
+                out.append(data, len);
+
+            sent_bytes_ += out.size();
 
             timeout_.disarm();
 
-#undef PST_OUT
+            auto fd         = peer()->fd();
+            const auto size = out.size();
 
-            auto fd = peer()->fd();
+            auto send = [transport = transport_, fd, size, out = std::move(out)]() mutable {
+                return transport->asyncWrite(fd, RawBuffer(std::move(out), size))
+                    .then<std::function<Async::Promise<PST_SSIZE_T>(PST_SSIZE_T)>,
+                          std::function<void(std::exception_ptr&)>>(
+                        [](PST_SSIZE_T data) {
+                            return Async::Promise<PST_SSIZE_T>::resolved(data);
+                        },
 
-            return transport_->asyncWrite(fd, buffer)
-                .then<std::function<Async::Promise<PST_SSIZE_T>(PST_SSIZE_T)>,
-                      std::function<void(std::exception_ptr&)>>(
-                    [](PST_SSIZE_T data) {
-                        return Async::Promise<PST_SSIZE_T>::resolved(data);
-                    },
+                        [](std::exception_ptr& eptr) {
+                            return Async::Promise<PST_SSIZE_T>::rejected(eptr);
+                        });
+            };
+
+            auto sent = turn_ ? turn_->write(std::move(send)) : send();
+
+            // The whole response is queued, the next one can follow
+            if (turn_)
+                turn_->close();
+
+            if (closesConnection(response_.headers()))
+                shutdownAfter(sent, peer_);
 
-                    [](std::exception_ptr& eptr) {
-                        return Async::Promise<PST_SSIZE_T>::rejected(eptr);
-                    });
+            return sent;
         }
         catch (const std::runtime_error& e)
         {
@@ -1168,6 +2017,20 @@ namespace Pistache::Http
     Async::Promise<PST_SSIZE_T> serveFile(ResponseWriter& writer,
                                           const std::string& fileName,
                                           const Mime::MediaType& contentType)
+    {
+        return writer.putFile(nullptr, fileName, contentType);
+    }
+
+    Async::Promise<PST_SSIZE_T> serveFile(ResponseWriter& writer, const Request& request,
+                                          const std::string& fileName,
+                                          const Mime::MediaType& contentType)
+    {
+        return writer.putFile(&request, fileName, contentType);
+    }
+
+    Async::Promise<PST_SSIZE_T> ResponseWriter::putFile(const Request* request,
+                                                        const std::string& fileName,
+                                                        const Mime::MediaType& contentType)
     {
         struct stat sb;
 
@@ -1191,38 +2054,20 @@ namespace Pistache::Http
         }
 
         int res = ::fstat(fd, &sb);
-
-        PST_FILE_CLOSE(fd); // Done with fd, close before error can be thrown
         if (res == -1)
         {
+            PST_FILE_CLOSE(fd); // Done with fd, close before error can be thrown
             throw HttpError(Code::Internal_Server_Error, "");
         }
 
-        auto* buf = writer.rdbuf();
-
-        std::ostream os(buf);
-
-#define PST_OUT(...)                                      \
-    do                                                    \
-    {                                                     \
-        __VA_ARGS__;                                      \
-        if (!os)                                          \
-        {                                                 \
-            return Async::Promise<PST_SSIZE_T>::rejected( \
-                Error("Response exceeded buffer size"));  \
-        }                                                 \
-    } while (0);
-
         auto setContentType = [&](const Mime::MediaType& contentType) {
-            auto& headers = writer.headers();
-            auto ct       = headers.tryGet<Header::ContentType>();
+            auto ct = headers().tryGet<Header::ContentType>();
             if (ct)
                 ct->setMime(contentType);
             else
-                headers.add<Header::ContentType>(contentType);
+                headers().add<Header::ContentType>(contentType);
         };
 
-        PST_OUT(writeStatusLine(writer.response_.version(), Http::Code::Ok, *buf));
         if (contentType.isValid())
         {
             setContentType(contentType);
@@ -1234,41 +2079,171 @@ namespace Pistache::Http
                 setContentType(mime);
         }
 
-        PST_OUT(writeHeaders(writer.headers(), *buf));
+        FileContent file;
+        file.fd           = fd;
+        file.size         = static_cast<size_t>(sb.st_size);
+        file.lastModified = std::chrono::system_clock::from_time_t(sb.st_mtime);
+        file.etag         = Private::fileETag(sb.st_mtime, file.size);
+
+        // The file is sent from the descriptor opened above, rather than
+        // opened again
+        return putFileOnWire(request, std::move(file));
+    }
+
+    Async::Promise<PST_SSIZE_T> ResponseWriter::putFileOnWire(const Request* request,
+                                                              FileContent file)
+    {
+        // Closes fd on the ways out that do not hand it to the transport
+        auto release = [&file]() {
+            if (file.fd != -1)
+                PST_FILE_CLOSE(file.fd);
+            file.fd = -1;
+        };
+
+        std::shared_ptr<Tcp::Peer> curPeer;
+        try
+        {
+            curPeer = peer();
+        }
+        catch (...)
+        {
+            release();
+            throw;
+        }
+
+        auto& hdrs = headers();
+        if (!hdrs.has<Header::ETag>())
+            hdrs.add<Header::ETag>(file.etag);
+        if (!hdrs.has<Header::LastModified>())
+            hdrs.add<Header::LastModified>(FullDate(file.lastModified));
 
-        const size_t len = static_cast<size_t>(sb.st_size);
+        std::vector<ByteRange> ranges;
+        auto code = Code::Ok;
+        if (request)
+        {
+            hdrs.add<AcceptRanges>("bytes");
+            code = evaluateFileRequest(*request, *hdrs.get<Header::ETag>(), file.lastModified,
+                                       file.size, ranges);
+        }
+        setCode(code);
 
-        PST_OUT(writeHeader<Header::ContentLength>(os, len));
+        if (code != Code::Ok && code != Code::Partial_Content)
+        {
+            release();
 
-        PST_OUT(os << crlf);
+            // What is answered is not the file anymore
+            hdrs.remove<Header::ContentType>();
+            if (code == Code::Requested_Range_Not_Satisfiable)
+            {
+                std::string unsatisfied("bytes */");
+                appendNumber(unsatisfied, file.size);
+                hdrs.add<ContentRange>(unsatisfied);
+            }
 
-        auto* transport = writer.transport_;
-        auto peer       = writer.peer();
-        auto sockFd     = peer->fd(); // may be PS_FD_EMPTY
+            return putOnWire(nullptr, 0);
+        }
 
-        auto buffer = buf->buffer();
-        return transport->asyncWrite(sockFd, buffer,
-#ifdef _USE_LIBEVENT_LIKE_APPLE
-                                     0, // MSG_MORE unsupported in macos sendmsg
-                                        // Instead, we set TCP_NOPUSH via
-                                        // setsockopt (see "man tcp").
-                                     true // use msg_more_style
-#else
-                                     MSG_MORE
-#endif
-                                     )
-            .then(
-                [=](PST_SSIZE_T) {
-                    return transport->asyncWrite(sockFd, FileBuffer(fileName));
-                },
-                Async::Throw);
+        auto body = std::make_shared<FileBody>();
+        if (ranges.empty())
+        {
+            body->pieces.push_back({ std::string(), 0, file.size });
+        }
+        else if (ranges.size() == 1)
+        {
+            hdrs.add<ContentRange>(contentRange(ranges[0].first, ranges[0].length, file.size));
+            body->pieces.push_back({ std::string(), ranges[0].first, ranges[0].length });
+        }
+        else
+        {
+            // Each range goes in its own part of a multipart/byteranges body
+            // (RFC 9110, 14.6), which has the content type of the file
+            const auto boundary = multipartBoundary();
 
-#undef PST_OUT
+            std::string partType;
+            if (auto ct = hdrs.tryGet<Header::ContentType>())
+                partType = ct->mime().toString();
+
+            Mime::MediaType multipart(Mime::Type::Multipart, Mime::Subtype::ByteRanges);
+            multipart.setParam("boundary", boundary);
+            hdrs.remove<Header::ContentType>();
+            hdrs.add<Header::ContentType>(multipart);
+
+            for (const auto& range : ranges)
+            {
+                std::string prefix;
+                prefix.append(CRLF).append("--").append(boundary).append(CRLF);
+                if (!partType.empty())
+                    prefix.append("Content-Type: ").append(partType).append(CRLF);
+                prefix.append("Content-Range: ")
+                    .append(contentRange(range.first, range.length, file.size))
+                    .append(CRLF)
+                    .append(CRLF);
+
+                body->pieces.push_back({ std::move(prefix), range.first, range.length });
+            }
+
+            body->trailer.append(CRLF).append("--").append(boundary).append("--").append(CRLF);
+        }
+
+        if (!file.data)
+        {
+            std::string head;
+            head.reserve(HeadSizeHint + body->pieces.front().prefix.size());
+            appendHead(head, response_.version(), response_.code(), handler(), hdrs,
+                       &response_.cookies(), body->size());
+
+            if (head.size() > buf_.maxSize())
+            {
+                release();
+                return Async::Promise<PST_SSIZE_T>::rejected(
+                    Error("Response exceeded buffer size"));
+            }
+
+            sent_bytes_ += static_cast<PST_SSIZE_T>(head.size() + body->size());
+            body->pieces.front().prefix.insert(0, head);
+
+            timeout_.disarm();
+
+            // may be PS_FD_EMPTY
+            auto send = [transport = transport_, sockFd = curPeer->fd(), fd = file.fd,
+                         body = std::move(body)]() {
+                return sendFileBody(transport, sockFd, fd, body, 0);
+            };
+
+            auto sent = turn_ ? turn_->write(std::move(send)) : send();
+
+            // The body goes in several writes, the next response can only
+            // follow once they are all done with
+            if (turn_)
+            {
+                auto close = [turn = turn_]() { turn->close(); };
+                sent.then([close](PST_SSIZE_T) { close(); },
+                          [close](std::exception_ptr&) { close(); });
+            }
+
+            if (closesConnection(hdrs))
+                shutdownAfter(sent, peer_);
+
+            return sent;
+        }
+
+        // The file is in memory, its parts can go with the head
+        if (body->pieces.size() == 1 && body->trailer.empty())
+            return putOnWire(file.data + body->pieces[0].first, body->pieces[0].length);
+
+        std::string content;
+        content.reserve(body->size());
+        for (const auto& piece : body->pieces)
+            content.append(piece.prefix).append(file.data + piece.first, piece.length);
+        content.append(body->trailer);
+
+        return putOnWire(content.data(), content.size());
     }
 
     Private::ParserImpl<Http::Request>::ParserImpl(size_t maxDataSize)
         : ParserBase(maxDataSize)
         , request()
+        , responses(std::make_shared<ResponseSequencer>())
         , time_(std::chrono::steady_clock::now())
     {
         allSteps[0] = std::make_unique<RequestLineStep>(&request);
@@ -1276,9 +2251,9 @@ namespace Pistache::Http
         allSteps[2] = std::make_unique<BodyStep>(&request);
     }
 
-    void Private::ParserImpl<Http::Request>::reset()
+    void Private::ParserImpl<Http::Request>::resetMessage()
     {
-        ParserBase::reset();
+        ParserBase::resetMessage();
 
         request = Request();
         time_   = std::chrono::steady_clock::now();
@@ -1300,24 +2275,49 @@ namespace Pistache::Http
 
         auto parser   = getParser(peer);
         auto& request = parser->request;
+
+        if (parser->closing)
+        {
+            PS_LOG_DEBUG("Dropping input after the last request");
+
+            parser->reset();
+            return;
+        }
+
         try
         {
-            if (!parser->feed(buffer, len))
+            // A single read may carry several pipelined requests, possibly
+            // followed by the start of another one. They are handed to
+            // onRequest() one after the other, in arrival order, and their
+            // responses go out in that same order, however late they are
+            // sent: see Private::ResponseSequencer.
+            size_t fed = 0;
+            for (;;)
             {
-                PS_LOG_DEBUG("parser returned false");
+                fed += parser->feedSome(buffer + fed, len - fed);
 
-                parser->reset();
-                throw HttpError(Code::Request_Entity_Too_Large,
-                                "Request exceeded maximum buffer size");
-            }
+                auto state = parser->parse();
+                if (state != Private::State::Done)
+                {
+                    if (fed == len)
+                        break;
 
-            auto state = parser->parse();
+                    // Make room by dropping the requests handled so far,
+                    // the request being parsed fills the buffer otherwise
+                    if (parser->compact())
+                        continue;
+
+                    PS_LOG_DEBUG("parser buffer is full");
+
+                    parser->reset();
+                    throw HttpError(Code::Request_Entity_Too_Large,
+                                    "Request exceeded maximum buffer size");
+                }
 
-            if (state == Private::State::Done)
-            {
                 PS_LOG_DEBUG("Creating response");
 
-                ResponseWriter response(request.version(), transport(), this, peer);
+                ResponseWriter response(request.version(), transport(), this, peer,
+                                        std::make_shared<Private::ResponseTurn>(parser->responses));
 
 #ifdef LIBSTDCPP_SMARTPTR_LOCK_FIXME
                 request.associatePeer(peer);
@@ -1325,19 +2325,33 @@ namespace Pistache::Http
 
                 request.copyAddress(peer->address());
 
+                // HTTP/1.1 connections persist unless the client says
+                // otherwise, HTTP/1.0 ones only when the client asks for it
+                // (RFC 9112 section 9.3)
                 auto connection = request.headers().tryGet<Header::Connection>();
+                const auto control = connection ? connection->control() : ConnectionControl::Ext;
 
-                if (connection)
-                {
-                    PS_LOG_DEBUG("Response connection control");
+                bool keepAlive = request.version() == Version::Http11
+                    ? control != ConnectionControl::Close
+                    : control == ConnectionControl::KeepAlive;
 
-                    response.headers().add<Header::Connection>(connection->control());
-                }
-                else
+                ++parser->requests;
+                if (maxRequestsPerConnection_ != 0 && parser->requests >= maxRequestsPerConnection_)
+                    keepAlive = false;
+
+                if (!keepAlive)
                 {
                     PS_LOG_DEBUG("Response connection close");
 
+                    // The response then ends the connection
                     response.headers().add<Header::Connection>(ConnectionControl::Close);
+                    parser->closing = true;
+                }
+                else if (control == ConnectionControl::KeepAlive)
+                {
+                    PS_LOG_DEBUG("Response connection keep-alive");
+
+                    response.headers().add<Header::Connection>(ConnectionControl::KeepAlive);
                 }
 
                 PS_LOG_DEBUG("Calling peer->setIdle");
@@ -1346,15 +2360,29 @@ namespace Pistache::Http
                 PS_LOG_DEBUG("Calling onRequest");
                 onRequest(request, std::move(response));
 
-                PS_LOG_DEBUG("Calling parser->reset");
-                parser->reset();
+                // That was the last request, whatever follows is not to be
+                // processed (RFC 9112 section 9.6)
+                if (!keepAlive)
+                {
+                    PS_LOG_DEBUG("Calling parser->reset");
+                    parser->reset();
+                    break;
+                }
+
+                PS_LOG_DEBUG("Calling parser->nextMessage");
+                parser->nextMessage();
             }
+
+            // Once per read rather than per request, as this moves
+            // whatever is left of the input to the front of the buffer
+            parser->compact();
         }
         catch (const HttpError& err)
         {
             PS_LOG_DEBUG("HTTP Error");
 
-            ResponseWriter response(request.version(), transport(), this, peer);
+            ResponseWriter response(request.version(), transport(), this, peer,
+                                    std::make_shared<Private::ResponseTurn>(parser->responses));
             response.send(static_cast<Code>(err.code()), err.reason());
             parser->reset();
         }
@@ -1363,15 +2391,37 @@ namespace Pistache::Http
         {
             PS_LOG_DEBUG("HTTP exception");
 
-            ResponseWriter response(request.version(), transport(), this, peer);
+            ResponseWriter response(request.version(), transport(), this, peer,
+                                    std::make_shared<Private::ResponseTurn>(parser->responses));
             response.send(Code::Internal_Server_Error, e.what());
             parser->reset();
         }
+
+        // The parser may have moved to another step, or been reset
+        transport()->touchPeer(peer);
+    }
+
+    char* Handler::prepareInput(const std::shared_ptr<Tcp::Peer>& peer, size_t& size)
+    {
+        // When the buffer is full, onInput() gets to report it
+        return getParser(peer)->prepare(size);
+    }
+
+    void Handler::commitInput(size_t len, const std::shared_ptr<Tcp::Peer>& peer)
+    {
+        getParser(peer)->commit(len);
+
+        // Parses what has just been committed
+        onInput(nullptr, 0, peer);
     }
 
     void Handler::onConnection(const std::shared_ptr<Tcp::Peer>& peer)
     {
-        peer->putData(ParserData, std::make_shared<RequestParser>(maxRequestSize_));
+        auto parser = std::make_shared<RequestParser>(maxRequestSize_);
+        parser->setLazyHeaders(lazyHeaders_);
+        peer->putData(ParserData, parser);
+
+        transport()->touchPeer(peer);
     }
 
     void Handler::onTimeout(const Request& /*request*/,
@@ -1384,31 +2434,61 @@ namespace Pistache::Http
 
     void Timeout::disarm()
     {
-        if (transport && armed)
+        if (transport && timerId != 0)
         {
-            transport->disarmTimer(timerFd);
+            transport->cancelTimeout(timerId);
+            timerId = 0;
         }
     }
 
-    bool Timeout::isArmed() const { return armed; }
+    bool Timeout::isArmed() const
+    {
+        return transport && timerId != 0 && transport->hasTimeout(timerId);
+    }
+
+    Timeout::Timeout(const Timeout& other)
+        : handler(other.handler)
+        , version(other.version)
+        , transport(other.transport)
+        , timerId(0)
+        , peer(other.peer)
+        , turn(other.turn)
+    { }
 
     Timeout::Timeout(Tcp::Transport* transport_, Http::Version version, Handler* handler_,
-                     std::weak_ptr<Tcp::Peer> peer_)
+                     std::weak_ptr<Tcp::Peer> peer_,
+                     std::weak_ptr<Private::ResponseTurn> turn_)
         : handler(handler_)
         , version(version)
         , transport(transport_)
-        , armed(false)
-        , timerFd(PS_FD_EMPTY)
+        , timerId(0)
         , peer(peer_)
+        , turn(std::move(turn_))
     { }
 
-    void Timeout::onTimeout(uint64_t /*numWakeup*/)
+    void Timeout::armMs(std::chrono::milliseconds duration)
+    {
+        disarm();
+
+        // The callback may outlive this timeout, which is moved around along
+        // with its ResponseWriter, so it gets its own copy of what it needs
+        timerId = transport->armTimeout(
+            duration,
+            [handler = handler, version = version, transport = transport, peer = peer,
+             turn = turn]() { onTimeout(handler, version, transport, peer, turn); });
+    }
+
+    void Timeout::onTimeout(Handler* handler, Http::Version version,
+                            Tcp::Transport* transport,
+                            const std::weak_ptr<Tcp::Peer>& peer,
+                            const std::weak_ptr<Private::ResponseTurn>& turn)
     {
         auto sp = peer.lock();
         if (!sp)
             return;
 
-        ResponseWriter response(version, transport, handler, peer);
+        // Sent in place of the response that timed out
+        ResponseWriter response(version, transport, handler, peer, turn.lock());
         auto parser         = Handler::getParser(sp);
         const auto& request = parser->request;
         handler->onTimeout(request, std::move(response));
@@ -1422,6 +2502,22 @@ namespace Pistache::Http
 
     size_t Handler::getMaxResponseSize() const { return maxResponseSize_; }
 
+    void Handler::setLazyHeaders(bool value) { lazyHeaders_ = value; }
+
+    bool Handler::getLazyHeaders() const { return lazyHeaders_; }
+
+    void Handler::setDateHeader(bool value) { dateHeader_ = value; }
+
+    bool Handler::getDateHeader() const { return dateHeader_; }
+
+    void Handler::setServerHeader(std::string value) { serverHeader_ = std::move(value); }
+
+    const std::string& Handler::getServerHeader() const { return serverHeader_; }
+
+    void Handler::setMaxRequestsPerConnection(size_t value) { maxRequestsPerConnection_ = value; }
+
+    size_t Handler::getMaxRequestsPerConnection() const { return maxRequestsPerConnection_; }
+
     std::shared_ptr<RequestParser>
     Handler::getParser(const std::shared_ptr<Tcp::Peer>& peer)
     {
@@ -12,34 +12,19 @@
 
 #include <pistache/http_headers.h>
 
+#include <algorithm>
+#include <cctype>
 #include <memory>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace Pistache::Http::Header
 {
-    RegisterHeader(Accept);
-    RegisterHeader(AccessControlAllowOrigin);
-    RegisterHeader(AccessControlAllowHeaders);
-    RegisterHeader(AccessControlExposeHeaders);
-    RegisterHeader(AccessControlAllowMethods);
-    RegisterHeader(Allow);
-    RegisterHeader(CacheControl);
-    RegisterHeader(Connection);
-    RegisterHeader(AcceptEncoding);
-    RegisterHeader(ContentEncoding);
-    RegisterHeader(TransferEncoding);
-    RegisterHeader(ContentLength);
-    RegisterHeader(ContentType);
-    RegisterHeader(Authorization);
-    RegisterHeader(Date);
-    RegisterHeader(Expect);
-    RegisterHeader(Host);
-    RegisterHeader(LastModified);
-    RegisterHeader(Location);
-    RegisterHeader(Server);
-    RegisterHeader(UserAgent);
+#define PST_REGISTER_KNOWN_HEADER(Header) RegisterHeader(Header);
+    PISTACHE_KNOWN_HEADERS(PST_REGISTER_KNOWN_HEADER)
+#undef PST_REGISTER_KNOWN_HEADER
 
     bool strToQvalue(const char* str, float* qvalue, std::size_t* qvalueLen)
     {
@@ -161,19 +146,28 @@ namespace Pistache::Http::Header
     void Registry::registerHeader(const std::string& name,
                                   Registry::RegistryFunc func)
     {
-        auto it = registry.find(name);
-        if (it != std::end(registry))
+        if (find(name) != nullptr)
         {
             throw std::runtime_error("Header already registered");
         }
 
-        registry.insert(std::make_pair(name, std::move(func)));
+        const size_t index = Known::index(name);
+        if (index != Known::None)
+            knownRegistry[index] = std::move(func);
+        else
+            registry.insert(std::make_pair(name, std::move(func)));
     }
 
     std::vector<std::string> Registry::headersList()
     {
         std::vector<std::string> names;
-        names.reserve(registry.size());
+        names.reserve(knownRegistry.size() + registry.size());
+
+        for (size_t i = 0; i < knownRegistry.size(); ++i)
+        {
+            if (knownRegistry[i])
+                names.emplace_back(Known::Names[i]);
+        }
 
         for (const auto& header : registry)
         {
@@ -185,37 +179,113 @@ namespace Pistache::Http::Header
 
     std::unique_ptr<Header> Registry::makeHeader(const std::string& name)
     {
-        auto it = registry.find(name);
-        if (it == std::end(registry))
+        const auto* func = find(name);
+        if (func == nullptr)
         {
             throw std::runtime_error("Unknown header");
         }
 
-        return it->second();
+        return (*func)();
     }
 
     bool Registry::isRegistered(const std::string& name)
     {
+        return find(name) != nullptr;
+    }
+
+    const Registry::RegistryFunc* Registry::find(const std::string& name) const
+    {
+        const size_t index = Known::index(name);
+        if (index != Known::None)
+            return knownRegistry[index] ? &knownRegistry[index] : nullptr;
+
         auto it = registry.find(name);
-        return it != std::end(registry);
+        if (it == std::end(registry))
+            return nullptr;
+
+        return &it->second;
     }
 
     Collection& Collection::add(const std::shared_ptr<Header>& header)
     {
-        headers.insert(std::make_pair(header->name(), header));
+        materialize(header->name());
+        insert(header, Known::index(header->name()));
 
         return *this;
     }
 
     Collection& Collection::addRaw(const Raw& raw)
     {
+        materialize(raw.name());
         rawHeaders.insert(std::make_pair(raw.name(), raw));
         return *this;
     }
 
+    Collection& Collection::addLazy(std::string_view name, std::string_view value)
+    {
+        LazyHeader header;
+        header.nameOffset  = lazyBytes.size();
+        header.nameSize    = name.size();
+        header.valueOffset = header.nameOffset + name.size();
+        header.valueSize   = value.size();
+
+        lazyBytes.append(name);
+        lazyBytes.append(value);
+        lazyHeaders.push_back(header);
+
+        return *this;
+    }
+
+    void Collection::materialize(std::string_view name) const
+    {
+        if (lazyHeaders.empty())
+            return;
+
+        auto nameOf = [this](const LazyHeader& header) {
+            return std::string_view(lazyBytes).substr(header.nameOffset, header.nameSize);
+        };
+        auto matches = [&](const LazyHeader& header) {
+            return LowercaseEqual {}(nameOf(header), name);
+        };
+
+        auto it = std::find_if(lazyHeaders.begin(), lazyHeaders.end(), matches);
+        if (it == lazyHeaders.end())
+            return;
+
+        // As with eagerly added headers, the first occurrence of a name wins
+        const LazyHeader header = *it;
+        lazyHeaders.erase(std::remove_if(it, lazyHeaders.end(), matches), lazyHeaders.end());
+
+        std::string headerName(nameOf(header));
+        std::string value(lazyBytes, header.valueOffset, header.valueSize);
+
+        auto& registry     = Registry::instance();
+        const size_t index = Known::index(headerName);
+        if (registry.isRegistered(headerName) && !getImpl(headerName, index).first)
+        {
+            std::shared_ptr<Header> typed = registry.makeHeader(headerName);
+            rawHeaders.insert(std::make_pair(headerName, Raw(headerName, value)));
+            typed->parseRaw(value.data(), value.size());
+            insert(typed, index);
+        }
+        else
+        {
+            rawHeaders.insert(std::make_pair(headerName, Raw(headerName, std::move(value))));
+        }
+    }
+
+    void Collection::materializeAll() const
+    {
+        while (!lazyHeaders.empty())
+        {
+            const auto& header = lazyHeaders.front();
+            materialize(std::string_view(lazyBytes).substr(header.nameOffset, header.nameSize));
+        }
+    }
+
     std::shared_ptr<const Header> Collection::get(const std::string& name) const
     {
-        auto header = getImpl(name);
+        auto header = getImpl(name, Known::index(name));
         if (!header.first)
         {
             throw std::runtime_error("Could not find header");
@@ -226,7 +296,7 @@ namespace Pistache::Http::Header
 
     std::shared_ptr<Header> Collection::get(const std::string& name)
     {
-        auto header = getImpl(name);
+        auto header = getImpl(name, Known::index(name));
         if (!header.first)
         {
             throw std::runtime_error("Could not find header");
@@ -237,6 +307,7 @@ namespace Pistache::Http::Header
 
     Raw Collection::getRaw(const std::string& name) const
     {
+        materialize(name);
         auto it = rawHeaders.find(name);
         if (it == std::end(rawHeaders))
         {
@@ -249,7 +320,7 @@ namespace Pistache::Http::Header
     std::shared_ptr<const Header>
     Collection::tryGet(const std::string& name) const
     {
-        auto header = getImpl(name);
+        auto header = getImpl(name, Known::index(name));
         if (!header.first)
             return nullptr;
 
@@ -258,7 +329,7 @@ namespace Pistache::Http::Header
 
     std::shared_ptr<Header> Collection::tryGet(const std::string& name)
     {
-        auto header = getImpl(name);
+        auto header = getImpl(name, Known::index(name));
         if (!header.first)
             return nullptr;
 
@@ -267,6 +338,7 @@ namespace Pistache::Http::Header
 
     std::optional<Raw> Collection::tryGetRaw(const std::string& name) const
     {
+        materialize(name);
         auto it = rawHeaders.find(name);
         if (it == std::end(rawHeaders))
         {
@@ -278,13 +350,20 @@ namespace Pistache::Http::Header
 
     bool Collection::has(const std::string& name) const
     {
-        return getImpl(name).first;
+        return getImpl(name, Known::index(name)).first;
     }
 
     std::vector<std::shared_ptr<Header>> Collection::list() const
     {
+        materializeAll();
+
         std::vector<std::shared_ptr<Header>> ret;
-        ret.reserve(headers.size());
+        ret.reserve(knownHeaders.size() + headers.size());
+        for (const auto& h : knownHeaders)
+        {
+            if (h)
+                ret.push_back(h);
+        }
         for (const auto& h : headers)
         {
             ret.push_back(h.second);
@@ -295,6 +374,15 @@ namespace Pistache::Http::Header
 
     bool Collection::remove(const std::string& name)
     {
+        materialize(name);
+
+        const size_t index = Known::index(name);
+        if (index != Known::None && knownHeaders[index])
+        {
+            knownHeaders[index].reset();
+            return true;
+        }
+
         auto tit = headers.find(name);
         if (tit == std::end(headers))
         {
@@ -311,13 +399,24 @@ namespace Pistache::Http::Header
 
     void Collection::clear()
     {
+        knownHeaders.fill(nullptr);
         headers.clear();
         rawHeaders.clear();
+        lazyHeaders.clear();
+        lazyBytes.clear();
     }
 
     std::pair<bool, std::shared_ptr<Header>>
-    Collection::getImpl(const std::string& name) const
+    Collection::getImpl(std::string_view name, size_t knownIndex) const
     {
+        materialize(name);
+
+        if (knownIndex != Known::None)
+        {
+            const auto& header = knownHeaders[knownIndex];
+            return std::make_pair(header != nullptr, header);
+        }
+
         auto it = headers.find(name);
         if (it == std::end(headers))
         {
@@ -327,4 +426,17 @@ namespace Pistache::Http::Header
         return std::make_pair(true, it->second);
     }
 
+    void Collection::insert(const std::shared_ptr<Header>& header, size_t knownIndex) const
+    {
+        if (knownIndex != Known::None)
+        {
+            if (!knownHeaders[knownIndex])
+                knownHeaders[knownIndex] = header;
+        }
+        else
+        {
+            headers.insert(std::make_pair(header->name(), header));
+        }
+    }
+
 } // namespace Pistache::Http::Header
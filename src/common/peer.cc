@@ -14,8 +14,6 @@
 #include <iostream>
 #include <stdexcept>
 
-#include PST_ARPA_INET_HDR
-#include PST_NETDB_HDR
 #include PST_SOCKET_HDR
 
 #include <sys/types.h>
@@ -23,6 +21,7 @@
 #include <pistache/async.h>
 #include <pistache/peer.h>
 #include <pistache/pist_quote.h>
+#include <pistache/resolver.h>
 #include <pistache/transport.h>
 
 namespace Pistache::Tcp
@@ -78,41 +77,15 @@ namespace Pistache::Tcp
     const std::string& Peer::hostname()
     {
         if (hostname_.empty())
-        {
-            if (addr.family() == AF_UNIX)
-            {
-                //
-                // Communication through unix domain sockets is constrained to
-                // the local host.
-                //
-                hostname_.assign("localhost");
-            }
-            else
-            {
-                char host[NI_MAXHOST];
-                struct sockaddr_in sa;
-                sa.sin_family = AF_INET;
-                if (inet_pton(AF_INET, addr.host().c_str(), &sa.sin_addr) == 0)
-                {
-                    hostname_ = addr.host();
-                }
-                else
-                {
-                    if (!getnameinfo(
-                            reinterpret_cast<struct sockaddr*>(&sa),
-                            sizeof(sa), host, sizeof(host),
-                            nullptr, 0, // Service info
-                            NI_NAMEREQD // Raise an error if name resolution failed
-                            ))
-                    {
-                        hostname_.assign(static_cast<char*>(host));
-                    }
-                }
-            }
-        }
+            hostname_ = ReverseResolver::instance().resolveNow(addr);
         return hostname_;
     }
 
+    Async::Promise<std::string> Peer::resolveHostname() const
+    {
+        return ReverseResolver::instance().resolve(addr);
+    }
+
     void* Peer::ssl() const { return ssl_; }
     size_t Peer::getID() const { return id_; }
 
@@ -167,6 +140,32 @@ namespace Pistache::Tcp
         }
     }
 
+    void Peer::shutdownWrite()
+    {
+        PS_LOG_DEBUG_ARGS("peer %p, fd %" PIST_QUOTE(PS_FD_PRNTFCD),
+                          this, fd_);
+
+        auto this_fd = fd_;
+        if (this_fd == PS_FD_EMPTY)
+            return;
+
+#ifdef PISTACHE_USE_SSL
+        // A TLS client is told with a close_notify that the connection ends
+        // here, rather than having been cut. The client's own close_notify
+        // is not waited for.
+        if (ssl_)
+        {
+            if (SSL_shutdown(static_cast<SSL*>(ssl_)) < 0)
+            {
+                PS_LOG_DEBUG_ARGS("SSL_shutdown failed, last error 0x%08X", ERR_peek_last_error());
+                ERR_clear_error();
+            }
+        }
+#endif /* PISTACHE_USE_SSL */
+
+        PST_SOCK_SHUTDOWN(GET_ACTUAL_FD(this_fd), PST_SOCK_SHUT_WR);
+    }
+
     void Peer::putData(std::string name, std::shared_ptr<void> data)
     {
         auto it = data_.find(name);
@@ -674,6 +674,29 @@ PST_SSIZE_T pist_sock_recv(em_socket_t em_sock, void * buf, size_t len,
 
 /* ------------------------------------------------------------------------- */
 
+// how is SD_RECEIVE, SD_SEND or SD_BOTH. On success, returns 0. On failure,
+// -1 is returned and errno is set.
+int pist_sock_shutdown(em_socket_t em_sock, int how)
+{
+    PIST_SOCK_STARTUP_CHECK_RET_MINUS_1_ON_ERR;
+
+    SOCKET win_sock = get_win_socket_from_em_socket_t(em_sock);
+    if (win_sock == INVALID_SOCKET)
+    {
+        PS_LOG_DEBUG("Invalid Socket");
+        errno = EBADF;
+        return(-1);
+    }
+
+    int shutdown_res = ::shutdown(win_sock, how);
+    if (shutdown_res == 0)
+        return(0); // success
+
+    return(WSAGetLastErrorSetErrno());
+}
+
+/* ------------------------------------------------------------------------- */
+
 // On success, returns 0. On failure, -1 is returned and errno is set.
 int pist_sock_select(int nfds, fd_set * readfds, fd_set * writefds,
                      fd_set * exceptfds, const struct timeval * timeout)
@@ -0,0 +1,339 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* resolver.cc
+
+   Implementation of the reverse DNS resolver
+*/
+
+#include <pistache/winornix.h>
+
+#include <pistache/resolver.h>
+
+#include PST_NETDB_HDR
+#include PST_SOCKET_HDR
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Pistache
+{
+
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Blocks for as long as the DNS server takes to answer
+        std::string lookup(const Address& address)
+        {
+            char host[NI_MAXHOST];
+            if (::getnameinfo(&address.getSockAddr(), address.addrLen(), host, sizeof(host),
+                              nullptr, 0, // Service info
+                              NI_NAMEREQD // Raise an error if name resolution failed
+                              ))
+                return std::string();
+
+            return std::string(host);
+        }
+    } // namespace
+
+    struct ReverseResolver::State
+    {
+        struct Entry
+        {
+            std::string ip;
+            std::string name;
+            Clock::time_point expires;
+        };
+
+        struct Job
+        {
+            Address address;
+            std::string ip;
+        };
+
+        // Looks up the addresses queued, until stop is set
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                cv.wait(lock, [this] { return stop || !jobs.empty(); });
+                if (stop)
+                    return;
+
+                auto job = std::move(jobs.front());
+                jobs.pop_front();
+
+                lock.unlock();
+                auto name = lookup(job.address);
+                lock.lock();
+
+                finish(lock, job.ip, std::move(name));
+            }
+        }
+
+        // Caches the name of ip and hands it to everyone waiting for it.
+        // Called with lock held, which is released while the waiters run
+        void finish(std::unique_lock<std::mutex>& lock, const std::string& ip, std::string name)
+        {
+            store(ip, name);
+
+            auto it = pending.find(ip);
+            if (it == pending.end())
+                return;
+
+            auto waiting = std::move(it->second);
+            pending.erase(it);
+
+            lock.unlock();
+            for (auto& deferred : waiting)
+                deferred.resolve(name);
+            lock.lock();
+        }
+
+        // Called with mutex held
+        std::optional<std::string> find(const std::string& ip)
+        {
+            auto it = index.find(ip);
+            if (it == index.end())
+                return std::nullopt;
+
+            if (Clock::now() >= it->second->expires)
+            {
+                entries.erase(it->second);
+                index.erase(it);
+                return std::nullopt;
+            }
+
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->name;
+        }
+
+        // Called with mutex held
+        void store(const std::string& ip, const std::string& name)
+        {
+            const auto expires = Clock::now() + (name.empty() ? negativeTtl : ttl);
+
+            auto it = index.find(ip);
+            if (it != index.end())
+            {
+                it->second->name    = name;
+                it->second->expires = expires;
+                entries.splice(entries.begin(), entries, it->second);
+                return;
+            }
+
+            if (maxEntries == 0)
+                return;
+
+            while (entries.size() >= maxEntries)
+            {
+                index.erase(entries.back().ip);
+                entries.pop_back();
+            }
+
+            entries.push_front(Entry { ip, name, expires });
+            index.emplace(ip, entries.begin());
+        }
+
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        bool stop = false;
+
+        // Most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+        // An address is pending from the time it is first asked for until
+        // its lookup is done, whether on a pool thread or in resolveNow()
+        std::deque<Job> jobs;
+        std::unordered_map<std::string, std::vector<Async::Deferred<std::string>>> pending;
+        std::vector<std::thread> workers;
+
+        size_t maxEntries                     = DefaultMaxEntries;
+        size_t maxPending                     = DefaultMaxPending;
+        std::chrono::milliseconds ttl         = std::chrono::minutes(5);
+        std::chrono::milliseconds negativeTtl = std::chrono::seconds(30);
+    };
+
+    ReverseResolver& ReverseResolver::instance()
+    {
+        static ReverseResolver resolver;
+        return resolver;
+    }
+
+    ReverseResolver::ReverseResolver()
+        : state_(std::make_shared<State>())
+    { }
+
+    ReverseResolver::~ReverseResolver()
+    {
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> guard(state_->mutex);
+            state_->stop = true;
+            workers.swap(state_->workers);
+        }
+        state_->cv.notify_all();
+
+        // Not joined, since a thread in the middle of a lookup can be
+        // blocked in getnameinfo() for as long as the DNS server takes,
+        // which would hold up the exit of the process. It owns its share of
+        // the state, and returns once its lookup is done.
+        for (auto& worker : workers)
+            worker.detach();
+
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        for (auto& entry : state_->pending)
+        {
+            for (auto& deferred : entry.second)
+                deferred.reject(std::runtime_error("Reverse resolver stopped"));
+        }
+        state_->pending.clear();
+        state_->jobs.clear();
+    }
+
+    Async::Promise<std::string> ReverseResolver::resolve(const Address& address)
+    {
+        if (address.family() == AF_UNIX)
+            return Async::Promise<std::string>::resolved(std::string("localhost"));
+
+        auto ip = address.host();
+
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        if (auto name = state_->find(ip))
+            return Async::Promise<std::string>::resolved(std::move(*name));
+
+        if (state_->stop)
+            return Async::Promise<std::string>::rejected(
+                std::runtime_error("Reverse resolver stopped"));
+
+        auto it = state_->pending.find(ip);
+        if (it == state_->pending.end())
+        {
+            // A slow DNS server must not let the backlog grow with every
+            // new peer address
+            if (state_->pending.size() >= state_->maxPending)
+                return Async::Promise<std::string>::rejected(
+                    std::runtime_error("Too many pending reverse lookups"));
+
+            it = state_->pending.emplace(ip, std::vector<Async::Deferred<std::string>>()).first;
+            state_->jobs.push_back(State::Job { address, ip });
+
+            // The pool grows on demand
+            if (state_->workers.size() < DefaultThreads)
+                state_->workers.emplace_back([state = state_] { state->run(); });
+            state_->cv.notify_one();
+        }
+
+        auto& waiting = it->second;
+        return Async::Promise<std::string>([&](Async::Deferred<std::string> deferred) {
+            waiting.push_back(std::move(deferred));
+        });
+    }
+
+    std::string ReverseResolver::resolveNow(const Address& address)
+    {
+        if (address.family() == AF_UNIX)
+            return "localhost";
+
+        auto ip = address.host();
+
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        if (auto name = state_->find(ip))
+            return *name;
+
+        // Someone is already looking the address up, wait for them
+        auto it = state_->pending.find(ip);
+        if (it != state_->pending.end())
+        {
+            auto waiting = std::make_shared<std::promise<std::string>>();
+            auto result  = waiting->get_future();
+
+            auto& deferreds = it->second;
+            Async::Promise<std::string> promise(
+                [&](Async::Deferred<std::string> deferred) { deferreds.push_back(std::move(deferred)); });
+            lock.unlock();
+
+            promise.then([waiting](const std::string& name) { waiting->set_value(name); },
+                         [waiting](std::exception_ptr) { waiting->set_value(std::string()); });
+            return result.get();
+        }
+
+        // Otherwise look it up here, letting others join in
+        state_->pending.emplace(ip, std::vector<Async::Deferred<std::string>>());
+        lock.unlock();
+
+        auto name = lookup(address);
+
+        lock.lock();
+        state_->finish(lock, ip, name);
+        return name;
+    }
+
+    std::optional<std::string> ReverseResolver::cached(const Address& address) const
+    {
+        if (address.family() == AF_UNIX)
+            return std::string("localhost");
+
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        return state_->find(address.host());
+    }
+
+    ReverseResolver& ReverseResolver::maxEntries(size_t count)
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        state_->maxEntries = count;
+        while (state_->entries.size() > count)
+        {
+            state_->index.erase(state_->entries.back().ip);
+            state_->entries.pop_back();
+        }
+        return *this;
+    }
+
+    ReverseResolver& ReverseResolver::maxPending(size_t count)
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        state_->maxPending = count;
+        return *this;
+    }
+
+    void ReverseResolver::setTtl(std::chrono::milliseconds ttl)
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        state_->ttl = ttl;
+    }
+
+    void ReverseResolver::setNegativeTtl(std::chrono::milliseconds ttl)
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        state_->negativeTtl = ttl;
+    }
+
+    size_t ReverseResolver::size() const
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        return state_->entries.size();
+    }
+
+    void ReverseResolver::clear()
+    {
+        std::lock_guard<std::mutex> guard(state_->mutex);
+        state_->entries.clear();
+        state_->index.clear();
+    }
+
+} // namespace Pistache
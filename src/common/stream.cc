@@ -15,6 +15,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -27,9 +29,130 @@
 #include PST_MISC_IO_HDR // unistd.h e.g. close
 #include PIST_FILEFNS_HDR // PST_FILE_OPEN
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PST_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
 namespace Pistache
 {
 
+    namespace
+    {
+        using FindAnyOfFn = const char* (*)(const char*, const char*, std::string_view);
+
+        const char* find_any_of_scalar(const char* begin, const char* end,
+                                       std::string_view chars)
+        {
+            for (; begin != end; ++begin)
+            {
+                if (chars.find(*begin) != std::string_view::npos)
+                    return begin;
+            }
+            return end;
+        }
+
+#ifdef PST_X86_SIMD
+        // Each needle costs one compare per block, so only a handful of
+        // needles are worth broadcasting
+        constexpr size_t MaxAvx2Needles = 8;
+
+        __attribute__((target("avx2"))) const char*
+        find_any_of_avx2(const char* begin, const char* end, std::string_view chars)
+        {
+            const size_t count = chars.size();
+            if (count > MaxAvx2Needles)
+                return find_any_of_scalar(begin, end, chars);
+
+            __m256i needles[MaxAvx2Needles];
+            for (size_t i = 0; i < count; ++i)
+                needles[i] = _mm256_set1_epi8(chars[i]);
+
+            while (end - begin >= 32)
+            {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+
+                __m256i eq = _mm256_cmpeq_epi8(block, needles[0]);
+                for (size_t i = 1; i < count; ++i)
+                    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(block, needles[i]));
+
+                const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+                if (mask != 0)
+                    return begin + __builtin_ctz(mask);
+
+                begin += 32;
+            }
+
+            return find_any_of_scalar(begin, end, chars);
+        }
+
+        __attribute__((target("sse4.2"))) const char*
+        find_any_of_sse42(const char* begin, const char* end, std::string_view chars)
+        {
+            const size_t count = chars.size();
+            if (count > 16)
+                return find_any_of_scalar(begin, end, chars);
+
+            char set[16] = {};
+            std::memcpy(set, chars.data(), count);
+            const __m128i needles = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set));
+            const int needlesLen  = static_cast<int>(count);
+
+            while (end - begin >= 16)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                const int idx       = _mm_cmpestri(
+                    needles, needlesLen, block, 16,
+                    _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+                if (idx != 16)
+                    return begin + idx;
+
+                begin += 16;
+            }
+
+            return find_any_of_scalar(begin, end, chars);
+        }
+#endif
+
+        FindAnyOfFn select_find_any_of()
+        {
+#ifdef PST_X86_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return find_any_of_avx2;
+            if (__builtin_cpu_supports("sse4.2"))
+                return find_any_of_sse42;
+#endif
+            return find_any_of_scalar;
+        }
+
+        // Letters are the only bytes that match_until() compares
+        // case-insensitively; any other delimiter set is an exact match
+        bool has_alpha(std::initializer_list<char> chars)
+        {
+            return std::any_of(chars.begin(), chars.end(), [](char c) {
+                return std::isalpha(static_cast<unsigned char>(c)) != 0;
+            });
+        }
+
+    } // namespace
+
+    const char* find_any_of(const char* begin, const char* end, std::string_view chars)
+    {
+        if (begin == end || chars.empty())
+            return end;
+
+        // The C library already vectorizes single-byte searches
+        if (chars.size() == 1)
+        {
+            const void* found = std::memchr(begin, chars[0], static_cast<size_t>(end - begin));
+            return found ? static_cast<const char*>(found) : end;
+        }
+
+        static const FindAnyOfFn impl = select_find_any_of();
+        return impl(begin, end, chars);
+    }
+
     RawBuffer::RawBuffer(std::string data, size_t length)
         : data_(std::move(data))
         , length_(length)
@@ -90,22 +213,39 @@ namespace Pistache
         size_ = sb.st_size;
     }
 
+    FileBuffer::FileBuffer(int fd, size_t size)
+        : fileName_()
+        , fd_(fd)
+        , size_(size)
+    { }
+
+    FileBuffer::FileBuffer(int fd, off_t offset, size_t size)
+        : fileName_()
+        , fd_(fd)
+        , offset_(offset)
+        , size_(size)
+    { }
+
     int FileBuffer::fd() const { return fd_; }
 
+    off_t FileBuffer::offset() const { return offset_; }
+
     size_t FileBuffer::size() const { return size_; }
 
     DynamicStreamBuf::DynamicStreamBuf(size_t size, size_t maxSize)
         : data_()
         , maxSize_(maxSize)
+        , initialSize_(size)
     {
         assert(size <= maxSize);
 
-        reserve(size);
+        this->setp(nullptr, nullptr);
     }
 
     DynamicStreamBuf::DynamicStreamBuf(DynamicStreamBuf&& other)
         : data_(std::move(other.data_))
         , maxSize_(other.maxSize_)
+        , initialSize_(other.initialSize_)
     {
         setp(other.pptr(), other.epptr());
         other.setp(nullptr, nullptr);
@@ -115,8 +255,9 @@ namespace Pistache
     {
         if (&other != this)
         {
-            data_    = std::move(other.data_);
-            maxSize_ = other.maxSize_;
+            data_        = std::move(other.data_);
+            maxSize_     = other.maxSize_;
+            initialSize_ = other.initialSize_;
             setp(other.pptr(), other.epptr());
             other.setp(nullptr, nullptr);
         }
@@ -126,9 +267,20 @@ namespace Pistache
 
     RawBuffer DynamicStreamBuf::buffer() const
     {
+        if (data_.empty())
+            return RawBuffer();
+
         return RawBuffer(data_.data(), pptr() - data_.data());
     }
 
+    std::string_view DynamicStreamBuf::view() const
+    {
+        if (data_.empty())
+            return std::string_view();
+
+        return std::string_view(data_.data(), static_cast<size_t>(pptr() - data_.data()));
+    }
+
     size_t DynamicStreamBuf::maxSize() const { return maxSize_; }
 
     void DynamicStreamBuf::clear()
@@ -145,7 +297,7 @@ namespace Pistache
             const auto size = data_.size();
             if (size < maxSize_)
             {
-                reserve((size ? size : 1u) * 2);
+                reserve(size ? size * 2 : std::max<size_t>(initialSize_, 1u));
                 *pptr() = static_cast<char>(ch);
                 pbump(1);
                 return traits_type::not_eof(ch);
@@ -172,10 +324,7 @@ namespace Pistache
         if (static_cast<PST_SSIZE_T>(count) > buf->in_avail())
             return false;
 
-        for (size_t i = 0; i < count; ++i)
-        {
-            buf->sbumpc();
-        }
+        buf->setArea(buf->begptr(), buf->curptr() + count, buf->endptr());
 
         return true;
     }
@@ -291,6 +440,15 @@ namespace Pistache
         if (cursor.eof())
             return false;
 
+        if (!has_alpha(chars))
+        {
+            const char* begin = cursor.offset();
+            const char* end   = begin + cursor.remaining();
+            const char* found = find_any_of(begin, end, std::string_view(chars.begin(), chars.size()));
+            cursor.advance(static_cast<size_t>(found - begin));
+            return found != end;
+        }
+
         auto find = [&](char val) {
             for (auto c : chars)
             {
@@ -27,6 +27,16 @@ namespace Pistache::Tcp
         transport_ = transport;
     }
 
+    char* Handler::prepareInput(const std::shared_ptr<Tcp::Peer>& /*peer*/,
+                                size_t& /*size*/)
+    {
+        return nullptr;
+    }
+
+    void Handler::commitInput(size_t /*len*/,
+                              const std::shared_ptr<Tcp::Peer>& /*peer*/)
+    { }
+
     void Handler::onConnection(const std::shared_ptr<Tcp::Peer>& /*peer*/)
     { }
 
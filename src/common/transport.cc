@@ -40,6 +40,10 @@
 #ifndef _USE_LIBEVENT_LIKE_APPLE
 // Note: sys/timerfd.h is linux-only (and certainly POSIX only)
 #include <sys/timerfd.h>
+
+#include <climits> // IOV_MAX
+#include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 
 #include <pistache/os.h>
@@ -48,6 +52,12 @@
 #include <pistache/transport.h>
 #include <pistache/utils.h>
 
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <utility>
+#include <vector>
+
 using std::to_string;
 
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -60,6 +70,18 @@ namespace Pistache::Tcp
 {
     using namespace Polling;
 
+#ifndef _USE_LIBEVENT_LIKE_APPLE
+    namespace
+    {
+        // Upper bound on the number of queued writes sent in one sendmsg
+#ifdef IOV_MAX
+        constexpr size_t MaxVectoredWrites = IOV_MAX;
+#else
+        constexpr size_t MaxVectoredWrites = 1024;
+#endif
+    }
+#endif
+
     Transport::Transport(const std::shared_ptr<Tcp::Handler>& handler)
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         : tcp_prot_num_(-1)
@@ -92,12 +114,14 @@ namespace Pistache::Tcp
 
     std::shared_ptr<Aio::Handler> Transport::clone() const
     {
-        return std::make_shared<Transport>(handler_->clone());
+        auto transport = std::make_shared<Transport>(handler_->clone());
+        transport->setReadBudget(readBudget_);
+        return transport;
     }
 
     void Transport::flush()
     {
-        handleWriteQueue(true);
+        handleWriteQueue();
     }
 
     void Transport::registerPoller(Polling::Epoll& poller)
@@ -108,10 +132,22 @@ namespace Pistache::Tcp
         timersQueue.bind(poller);
         peersQueue.bind(poller);
         notifier.bind(poller);
+        readyNotifier.bind(poller);
 
 #ifdef _USE_LIBEVENT
         epoll_fd = poller.getEventMethEpollEquiv();
 #endif
+
+        // Set up before the transport is shared with other threads, which
+        // may then arm timeouts right away
+        std::lock_guard<std::mutex> guard(timeoutsMutex_);
+        timeoutTimer_ = std::make_shared<TimerPool::Entry>();
+        timeoutTimer_->initialize();
+        poller.addFd(timeoutTimer_->fd(), Flags<NotifyOn>(NotifyOn::Read),
+                     Polling::Tag(timeoutTimer_->fd()));
+
+        if (!timeoutDeadlines_.empty())
+            armTimeoutTimer(timeoutDeadlines_.front().first);
     }
 
     void Transport::unregisterPoller(Polling::Epoll& poller)
@@ -122,6 +158,35 @@ namespace Pistache::Tcp
         epoll_fd = nullptr;
 #endif
 
+        if (acceptorFd_ != PS_FD_EMPTY)
+        {
+            Aio::Reactor* r = reactor();
+            if (r)
+                r->removeFd(key(), acceptorFd_);
+            acceptorFd_ = PS_FD_EMPTY;
+        }
+
+        if (handshakeTimer_)
+        {
+            Aio::Reactor* r = reactor();
+            if (r)
+                r->removeFd(key(), handshakeTimer_->fd());
+            handshakeTimer_.reset();
+            handshakeTimerDeadline_ = std::chrono::steady_clock::time_point::max();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(timeoutsMutex_);
+            if (timeoutTimer_)
+            {
+                poller.removeFd(timeoutTimer_->fd());
+                timeoutTimer_.reset();
+                timeoutTimerDeadline_ = std::chrono::steady_clock::time_point::max();
+            }
+        }
+
+        readyPeers_.clear();
+        readyNotifier.unbind(poller);
         notifier.unbind(poller);
         peersQueue.unbind(poller);
         timersQueue.unbind(poller);
@@ -133,6 +198,8 @@ namespace Pistache::Tcp
         auto ctx                   = context();
         const bool isInRightThread = std::this_thread::get_id() == ctx.thread();
 
+        ++pendingPeers_;
+
         if (!isInRightThread)
         {
             PS_LOG_DEBUG("Pushing to peersQueue");
@@ -218,63 +285,95 @@ namespace Pistache::Tcp
                 PS_LOG_DEBUG("notifier");
                 handleNotify();
             }
+            else if (entry.getTag() == readyNotifier.tag())
+            {
+                PS_LOG_DEBUG("Ready peers");
+                handleReadyPeers();
+            }
+            else if (acceptorFd_ != PS_FD_EMPTY && entry.getTag() == Polling::Tag(acceptorFd_))
+            {
+                PS_LOG_DEBUG("Acceptor");
+                handleAcceptor();
+            }
+            else if (timeoutTimer_ && entry.getTag() == Polling::Tag(timeoutTimer_->fd()))
+            {
+                PS_LOG_DEBUG("Timeout timer");
+                handleTimeoutTimer();
+            }
+            else if (handshakeTimer_ && entry.getTag() == Polling::Tag(handshakeTimer_->fd()))
+            {
+                PS_LOG_DEBUG("Handshake timer");
+                handleHandshakeTimer();
+            }
+            else if (auto it = handshakes_.find(PS_CAST_AWAY_CONST_FD(static_cast<FdConst>(entry.getTag().value())));
+                     it != handshakes_.end())
+            {
+                PS_LOG_DEBUG("handleHandshake");
+                auto peer = it->second;
+                handleHandshake(peer);
+            }
 
-            else if (entry.isReadable())
+            else
             {
                 auto tag = entry.getTag();
-                PS_LOG_DEBUG_ARGS("entry isReadable fd %" PIST_QUOTE(PS_FD_PRNTFCD),
-                                  tag.value()); // TagValue type := Fd
 
-                if (isPeerFd(tag))
-                {
-                    auto peer = getPeer(tag);
-                    PS_LOG_DEBUG("handleIncoming");
-                    handleIncoming(peer);
-                }
-                else if (isTimerFd(tag))
+                // Looked up once for both directions
+                std::shared_ptr<Peer> peer;
+
+                if (entry.isReadable())
                 {
-                    auto it      = timers.find(static_cast<decltype(timers)::key_type>(tag.value()));
-                    auto& entry_ = it->second;
-                    PS_LOG_DEBUG("handleTimer");
-                    handleTimer(std::move(entry_));
-                    PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erased from timers",
-                                      it->first);
-
-                    PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erasing from timers",
-                                      it->first);
-                    timers.erase(it->first);
+                    PS_LOG_DEBUG_ARGS("entry isReadable fd %" PIST_QUOTE(PS_FD_PRNTFCD),
+                                      tag.value()); // TagValue type := Fd
+
+                    peer = findPeer(static_cast<FdConst>(tag.value()));
+                    if (peer)
+                    {
+                        PS_LOG_DEBUG("handleIncoming");
+                        handleIncoming(peer);
+                    }
+                    else if (isTimerFd(tag))
+                    {
+                        auto it      = timers.find(static_cast<decltype(timers)::key_type>(tag.value()));
+                        auto& entry_ = it->second;
+                        PS_LOG_DEBUG("handleTimer");
+                        handleTimer(std::move(entry_));
+                        PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erased from timers",
+                                          it->first);
+
+                        PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erasing from timers",
+                                          it->first);
+                        timers.erase(it->first);
+                        continue;
+                    }
+                    else
+                    {
+                        PS_LOG_DEBUG("neither peer nor timer");
+                    }
                 }
-                else
+
+                // Peers are watched for writability all along, see
+                // handlePeer(), and report it along with most of their
+                // events. It only matters to a peer whose writes wait for
+                // room in its socket, which its flag tells without taking
+                // toWriteLock.
+                if (entry.isWritable())
                 {
-                    PS_LOG_DEBUG("neither peer nor timer");
-                }
-            }
-            else if (entry.isWritable())
-            {
-                PS_LOG_DEBUG("isWritable");
+                    PS_LOG_DEBUG("isWritable");
 
-                auto tag        = entry.getTag();
-                FdConst fdconst = static_cast<FdConst>(tag.value());
-                // Since fd is about to be written to, it isn't really const,
-                // and we cast away the const
-                Fd fd = PS_CAST_AWAY_CONST_FD(fdconst);
+                    FdConst fdconst = static_cast<FdConst>(tag.value());
+                    // Since fd is about to be written to, it isn't really
+                    // const, and we cast away the const
+                    Fd fd = PS_CAST_AWAY_CONST_FD(fdconst);
 
-                {
-                    Guard guard(toWriteLock);
-                    auto it = toWrite.find(fd);
-                    if (it == std::end(toWrite))
+                    if (!peer && !entry.isReadable())
+                        peer = findPeer(fdconst);
+
+                    if (peer && peer->writesPending_.load(std::memory_order_acquire))
                     {
-                        // This can happen if another thread triggered an explicit
-                        // flush right when this thread woke up to write as well
-                        PS_LOG_DEBUG("fd not in toWrite, nothing to write");
+                        PS_LOG_DEBUG("asyncWriteImpl (drain queue)");
+                        asyncWriteImpl(fd, *peer);
                     }
                 }
-
-                reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
-
-                PS_LOG_DEBUG("asyncWriteImpl (drain queue)");
-                // Try to drain the queue
-                asyncWriteImpl(fd);
             }
         }
     }
@@ -291,6 +390,123 @@ namespace Pistache::Tcp
         entry.disable();
     }
 
+    Transport::TimeoutId Transport::armTimeoutMs(std::chrono::milliseconds timeout,
+                                                 std::function<void()> callback)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        std::lock_guard<std::mutex> guard(timeoutsMutex_);
+
+        const TimeoutId id = nextTimeoutId_++;
+        timeouts_.emplace(id, std::move(callback));
+        timeoutDeadlines_.emplace_back(deadline, id);
+        std::push_heap(timeoutDeadlines_.begin(), timeoutDeadlines_.end(),
+                       std::greater<TimeoutDeadline>());
+
+        armTimeoutTimer(deadline);
+        return id;
+    }
+
+    bool Transport::cancelTimeout(TimeoutId id)
+    {
+        std::lock_guard<std::mutex> guard(timeoutsMutex_);
+
+        if (timeouts_.erase(id) == 0)
+            return false;
+
+        // Deadlines are left in the heap, to be skipped once they are
+        // reached. Timeouts that keep being cancelled long before their
+        // deadline, such as when a handler responds in time, would pile up
+        // though, so weed them out once they outnumber the live ones.
+        if (timeoutDeadlines_.size() > 2 * timeouts_.size() + 64)
+        {
+            timeoutDeadlines_.erase(
+                std::remove_if(timeoutDeadlines_.begin(), timeoutDeadlines_.end(),
+                               [this](const TimeoutDeadline& deadline) {
+                                   return timeouts_.count(deadline.second) == 0;
+                               }),
+                timeoutDeadlines_.end());
+            std::make_heap(timeoutDeadlines_.begin(), timeoutDeadlines_.end(),
+                           std::greater<TimeoutDeadline>());
+        }
+
+        return true;
+    }
+
+    bool Transport::hasTimeout(TimeoutId id) const
+    {
+        std::lock_guard<std::mutex> guard(timeoutsMutex_);
+        return timeouts_.count(id) != 0;
+    }
+
+    void Transport::armTimeoutTimer(std::chrono::steady_clock::time_point deadline)
+    {
+        // Not bound to a poller yet, or already firing early enough
+        if (!timeoutTimer_ || deadline >= timeoutTimerDeadline_)
+            return;
+
+        // A zero duration would disarm the timer instead
+        const auto delay = std::max(
+            std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()),
+            std::chrono::milliseconds(1));
+
+        timeoutTimer_->arm(delay);
+        timeoutTimerDeadline_ = deadline;
+    }
+
+    void Transport::handleTimeoutTimer()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        uint64_t wakeups;
+        [[maybe_unused]] auto rv = READ_FD(timeoutTimer_->fd(), &wakeups, sizeof wakeups);
+
+        std::vector<std::function<void()>> expired;
+        {
+            std::lock_guard<std::mutex> guard(timeoutsMutex_);
+
+            const auto now = std::chrono::steady_clock::now();
+            while (!timeoutDeadlines_.empty())
+            {
+                const auto& top = timeoutDeadlines_.front();
+
+                auto it = timeouts_.find(top.second);
+                if (it != timeouts_.end())
+                {
+                    // The timer may have fired early, since it has a
+                    // granularity of one second for delays longer than that
+                    if (top.first > now)
+                        break;
+
+                    expired.push_back(std::move(it->second));
+                    timeouts_.erase(it);
+                }
+
+                std::pop_heap(timeoutDeadlines_.begin(), timeoutDeadlines_.end(),
+                              std::greater<TimeoutDeadline>());
+                timeoutDeadlines_.pop_back();
+            }
+
+            timeoutTimerDeadline_ = std::chrono::steady_clock::time_point::max();
+            if (!timeoutDeadlines_.empty())
+                armTimeoutTimer(timeoutDeadlines_.front().first);
+        }
+
+        // Outside of the lock, since callbacks are free to arm or cancel
+        // other timeouts
+        for (auto& callback : expired)
+        {
+            try
+            {
+                callback();
+            }
+            catch (const std::exception& ex)
+            {
+                PS_LOG_WARNING_ARGS("Timeout callback failed: %s", ex.what());
+            }
+        }
+    }
+
     void Transport::handleIncoming(const std::shared_ptr<Peer>& peer)
     {
         if (!peer)
@@ -299,18 +515,41 @@ namespace Pistache::Tcp
             return;
         }
 
-        char buffer[Const::MaxBuffer] = { 0 };
+        // Only used when the handler does not take the bytes in place
+        char buffer[Const::MaxBuffer];
 
-        PST_SSIZE_T totalBytes = 0;
-        em_socket_t fdactual   = peer->actualFd();
+        em_socket_t fdactual = peer->actualFd();
         if (fdactual < 0)
         {
             PS_LOG_DEBUG_ARGS("Peer %p has no actual Fd", peer.get());
             return;
         }
 
+        size_t total = 0;
         for (;;)
         {
+            // Leaves the rest for later, the socket staying readable without
+            // a new edge being reported for it
+            if (readBudget_ != 0 && total >= readBudget_)
+            {
+                if (!peer->readPending_)
+                {
+                    peer->readPending_ = true;
+                    if (readyPeers_.empty())
+                        readyNotifier.notify();
+                    readyPeers_.push_back(peer);
+                }
+                break;
+            }
+
+            size_t size        = Const::MaxBuffer;
+            char* dest         = handler_->prepareInput(peer, size);
+            const bool inPlace = dest != nullptr;
+            if (!inPlace)
+            {
+                dest = buffer;
+                size = Const::MaxBuffer;
+            }
 
             PST_SSIZE_T bytes = -1;
             bool retry        = false;
@@ -321,8 +560,7 @@ namespace Pistache::Tcp
                 PS_LOG_DEBUG("SSL_read");
 
                 bytes = SSL_read(reinterpret_cast<SSL*>(peer->ssl()),
-                                 buffer + totalBytes,
-                                 static_cast<int>(Const::MaxBuffer - totalBytes));
+                                 dest, static_cast<int>(size));
                 if (bytes <= 0)
                 {
                     int ssl_get_error_res = SSL_get_error(
@@ -352,8 +590,7 @@ namespace Pistache::Tcp
             {
 #endif /* PISTACHE_USE_SSL */
                 PS_LOG_DEBUG("recv (read)");
-                bytes = PST_SOCK_READ(fdactual, buffer + totalBytes,
-                                      Const::MaxBuffer - totalBytes);
+                bytes = PST_SOCK_READ(fdactual, dest, size);
                 if (bytes < 0)
                     retry = (errno == EAGAIN || errno == EWOULDBLOCK);
 #ifdef PISTACHE_USE_SSL
@@ -362,26 +599,18 @@ namespace Pistache::Tcp
 
             PST_DBG_DECL_SE_ERR_P_EXTRA;
             PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
-                                                               "bytes read %d, totalBytes %d, retry %s,"
+                                                               "bytes read %d, in place %s, retry %s,"
                                                                "err %d %s",
-                              peer->fd(), bytes, totalBytes,
+                              peer->fd(), bytes,
+                              (inPlace) ? "true" : "false",
                               (retry) ? "true" : "false",
                               (bytes < 0) ? errno : 0,
                               (bytes < 0) ? (PST_STRERROR_R_ERRNO) : "");
 
             if (bytes == -1)
             {
-                if (retry)
-                {
-                    if (totalBytes > 0)
-                    {
-                        handler_->onInput(buffer, totalBytes, peer);
-                    }
-                }
-                else
-                {
+                if (!retry)
                     handlePeerDisconnection(peer);
-                }
                 break;
             }
             else if (bytes == 0)
@@ -389,11 +618,35 @@ namespace Pistache::Tcp
                 handlePeerDisconnection(peer);
                 break;
             }
-
+            else if (inPlace)
+            {
+                handler_->commitInput(static_cast<size_t>(bytes), peer);
+            }
             else
             {
                 handler_->onInput(buffer, bytes, peer);
             }
+
+            total += static_cast<size_t>(bytes);
+        }
+    }
+
+    void Transport::handleReadyPeers()
+    {
+        // Reading an eventfd resets its counter, however many times it has
+        // been notified
+        readyNotifier.read();
+
+        // Only the peers queued so far get another turn now. Those that use
+        // up their budget again are queued for the next one, after the
+        // poller has been asked for the peers that became ready meanwhile.
+        auto peers = std::move(readyPeers_);
+        readyPeers_.clear();
+
+        for (const auto& peer : peers)
+        {
+            peer->readPending_ = false;
+            handleIncoming(peer);
         }
     }
 
@@ -404,6 +657,10 @@ namespace Pistache::Tcp
         removePeer(peer);
     }
 
+    void Transport::touchPeer(const std::shared_ptr<Peer>& /*peer*/) { }
+
+    void Transport::forgetPeer(const std::shared_ptr<Peer>& /*peer*/) { }
+
     void Transport::removePeer(const std::shared_ptr<Peer>& peer)
     {
         Fd fd = peer->fd();
@@ -427,6 +684,8 @@ namespace Pistache::Tcp
             }
         }
 
+        forgetPeer(peer);
+
         // Don't rely on close deleting this FD from the epoll "interest" list.
         // This is needed in case the FD has been shared with another process.
         // Sharing should no longer happen by accident as SOCK_CLOEXEC is now set on
@@ -458,6 +717,9 @@ namespace Pistache::Tcp
     {
         PS_TIMEDBG_START_THIS;
 
+        for (const auto& handshake : std::exchange(handshakes_, {}))
+            dropHandshake(handshake.second);
+
         for (;;)
         {
             std::shared_ptr<Peer> peer;
@@ -481,7 +743,7 @@ namespace Pistache::Tcp
         }
     }
 
-    void Transport::asyncWriteImpl(Fd fd)
+    void Transport::asyncWriteImpl(Fd fd, Peer& peer)
     {
         PS_TIMEDBG_START_THIS;
 
@@ -496,15 +758,34 @@ namespace Pistache::Tcp
             if (it == std::end(toWrite))
             {
                 PS_LOG_DEBUG_ARGS("Failed to find fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+                peer.writesPending_.store(false, std::memory_order_release);
                 return;
             }
             auto& wq = it->second;
             if (wq.empty())
             {
                 PS_LOG_DEBUG("wq empty");
+                peer.writesPending_.store(false, std::memory_order_release);
                 break;
             }
 
+            // Set before anything is sent, and only cleared once the queue
+            // is empty. A writable edge that follows a send failing with
+            // EAGAIN then always finds it set, even when the send was made
+            // by another thread, e.g. in flush(), that still holds
+            // toWriteLock when the edge comes in.
+            peer.writesPending_.store(true, std::memory_order_release);
+
+#ifndef _USE_LIBEVENT_LIKE_APPLE
+            // Several responses, or stream chunks, queued up for the same
+            // peer: send them together rather than one syscall each
+            if (wq.size() > 1 && wq[0].buffer.isRaw() && wq[1].buffer.isRaw() && canWriteVectored(fd))
+            {
+                if (asyncWriteVectored(fd, peer, wq, lock, stop))
+                    continue;
+            }
+#endif
+
             auto& entry = wq.front();
             int flags   = entry.flags;
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -519,7 +800,7 @@ namespace Pistache::Tcp
                 {
                     PS_LOG_DEBUG_ARGS("Erasing fd %" PIST_QUOTE(PS_FD_PRNTFCD) " from toWrite", fd);
                     toWrite.erase(fd);
-                    reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
+                    peer.writesPending_.store(false, std::memory_order_release);
                     stop = true;
                 }
                 lock.unlock();
@@ -536,7 +817,7 @@ namespace Pistache::Tcp
                     PS_LOG_DEBUG_ARGS("sendRawBuffer fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", len %d",
                                       fd, len);
 
-                    auto raw        = buffer.raw();
+                    const auto& raw = buffer.raw();
                     const auto* ptr = raw.data().c_str() + totalWritten;
                     bytesWritten    = sendRawBuffer(fd, ptr, len, flags
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -574,8 +855,9 @@ namespace Pistache::Tcp
                                                  msg_more_style
 #endif
                                                  ));
-                        reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
-                                            Polling::Mode::Edge);
+
+                        // Sent on by the writable edge the socket reports
+                        // once it has room again, writesPending_ being set
                         stop = true;
                     }
                     // EBADF can happen when the HTTP parser, in the case of
@@ -587,6 +869,7 @@ namespace Pistache::Tcp
                                           fd);
                         wq.pop_front();
                         toWrite.erase(fd);
+                        peer.writesPending_.store(false, std::memory_order_release);
                         stop = true;
                     }
                     else
@@ -625,6 +908,100 @@ namespace Pistache::Tcp
         }
     }
 
+#ifndef _USE_LIBEVENT_LIKE_APPLE
+    bool Transport::asyncWriteVectored(Fd fd, Peer& peer, std::deque<WriteEntry>& wq,
+                                       std::unique_lock<std::mutex>& lock,
+                                       bool& stop)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        struct iovec iov[MaxVectoredWrites];
+        size_t count = 0;
+        int flags    = 0;
+        for (auto& entry : wq)
+        {
+            if (count == MaxVectoredWrites || !entry.buffer.isRaw())
+                break;
+
+            const auto& data    = entry.buffer.raw().data();
+            iov[count].iov_base = const_cast<char*>(data.c_str()) + entry.buffer.offset();
+            iov[count].iov_len  = entry.buffer.size() - entry.buffer.offset();
+            // The flags of the last entry apply, e.g. MSG_MORE when a file
+            // follows the batch
+            flags = entry.flags;
+            ++count;
+        }
+
+        struct msghdr msg = {};
+        msg.msg_iov       = iov;
+        msg.msg_iovlen    = count;
+
+        PS_LOG_DEBUG_ARGS("sendmsg fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", %d buffers",
+                          fd, static_cast<int>(count));
+
+        // MSG_NOSIGNAL is used to prevent SIGPIPE on client connection
+        // termination
+        PST_SSIZE_T bytesWritten = ::sendmsg(GET_ACTUAL_FD(fd), &msg, flags | MSG_NOSIGNAL);
+        if (bytesWritten <= 0)
+        {
+            PST_DBG_DECL_SE_ERR_P_EXTRA;
+            PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " errno %d %s",
+                              fd, errno, PST_STRERROR_R_ERRNO);
+            return false;
+        }
+
+        // Pop the entries that went out entirely, and leave the remainder of
+        // a partially written one at the front of the queue
+        std::vector<std::pair<Async::Deferred<PST_SSIZE_T>, PST_SSIZE_T>> done;
+        auto remaining = static_cast<size_t>(bytesWritten);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto& entry = wq.front();
+            if (remaining < iov[i].iov_len)
+            {
+                if (remaining > 0)
+                {
+                    auto offset = static_cast<off_t>(entry.buffer.offset() + remaining);
+                    entry.buffer = entry.buffer.detach(offset);
+                }
+                break;
+            }
+
+            remaining -= iov[i].iov_len;
+            done.emplace_back(std::move(entry.deferred),
+                              static_cast<PST_SSIZE_T>(entry.buffer.size()));
+            wq.pop_front();
+        }
+
+        if (wq.empty())
+        {
+            PS_LOG_DEBUG_ARGS("Erasing fd %" PIST_QUOTE(PS_FD_PRNTFCD) " from toWrite", fd);
+            toWrite.erase(fd);
+            peer.writesPending_.store(false, std::memory_order_release);
+            stop = true;
+        }
+        lock.unlock();
+
+        for (auto& [deferred, size] : done)
+            deferred.resolve(size);
+
+        return true;
+    }
+
+    bool Transport::canWriteVectored([[maybe_unused]] Fd fd) const
+    {
+#ifdef PISTACHE_USE_SSL
+        // SSL_write has no vectored form
+        std::lock_guard<std::mutex> l_guard(peers_mutex_);
+
+        auto it = peers_.find(fd);
+        return it != std::end(peers_) && it->second && it->second->ssl() == nullptr;
+#else
+        return true;
+#endif
+    }
+#endif // ifndef _USE_LIBEVENT_LIKE_APPLE
+
 #ifdef _USE_LIBEVENT_LIKE_APPLE
     void Transport::configureMsgMoreStyle(Fd fd, bool msg_more_style)
     {
@@ -1038,8 +1415,14 @@ namespace Pistache::Tcp
         timers.insert(std::make_pair(entry.fd, std::move(entry)));
     }
 
-    void Transport::handleWriteQueue(bool flush)
+    void Transport::handleWriteQueue()
     {
+        // Peers that had nothing queued, and so are not waiting for room in
+        // their socket either. They are written to once the queue is
+        // drained, so that the writes queued together for a peer go out
+        // together.
+        std::vector<std::pair<Fd, std::shared_ptr<Peer>>> ready;
+
         // Let's drain the queue
         for (;;)
         {
@@ -1050,20 +1433,21 @@ namespace Pistache::Tcp
             auto fd = write->peerFd;
             if (fd == PS_FD_EMPTY)
                 continue;
-            if (!isPeerFd(fd))
+            auto peer = findPeer(fd);
+            if (!peer)
                 continue;
 
             {
                 Guard guard(toWriteLock);
-                toWrite[fd].push_back(std::move(*write));
+                auto& wq = toWrite[fd];
+                if (wq.empty())
+                    ready.emplace_back(fd, std::move(peer));
+                wq.push_back(std::move(*write));
             }
-
-            if (flush)
-                asyncWriteImpl(fd);
-            else
-                reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
-                                    Polling::Mode::Edge);
         }
+
+        for (const auto& [fd, peer] : ready)
+            asyncWriteImpl(fd, *peer);
     }
 
     void Transport::handleTimerQueue()
@@ -1080,6 +1464,48 @@ namespace Pistache::Tcp
         }
     }
 
+    void Transport::setReadBudget(size_t budget) { readBudget_ = budget; }
+
+    void Transport::setLogger(PISTACHE_STRING_LOGGER_T logger) { logger_ = std::move(logger); }
+
+    size_t Transport::readBudget() const { return readBudget_; }
+
+    void Transport::setAcceptor(Fd listenFd, Acceptor acceptor, size_t budget)
+    {
+        acceptorFd_   = listenFd;
+        acceptor_     = std::move(acceptor);
+        acceptBudget_ = std::max<size_t>(budget, 1);
+
+        reactor()->registerFd(key(), listenFd, NotifyOn::Read);
+    }
+
+    void Transport::handleAcceptor()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        // The listening socket is level-triggered, so any connection left
+        // pending once the budget is used up is reported again on the next
+        // poll
+        for (size_t i = 0; i < acceptBudget_; ++i)
+        {
+            std::shared_ptr<Peer> peer;
+            try
+            {
+                peer = acceptor_(acceptorFd_);
+            }
+            catch (const std::exception& ex)
+            {
+                PS_LOG_WARNING_ARGS("Accept failed: %s", ex.what());
+                return;
+            }
+
+            if (!peer)
+                return;
+
+            handleNewPeer(peer);
+        }
+    }
+
     void Transport::handlePeerQueue()
     {
         PS_TIMEDBG_START_THIS;
@@ -1103,9 +1529,35 @@ namespace Pistache::Tcp
         if (fd == PS_FD_EMPTY)
         {
             PS_LOG_DEBUG("Empty Fd");
+            --pendingPeers_;
             return;
         }
 
+        if (peer->handshakePending_)
+        {
+            // Both directions are watched, as SSL_do_handshake can need
+            // either, and the peer then stays registered that way
+            handshakes_.emplace(fd, peer);
+            peer->associateTransport(this);
+            reactor()->registerFd(key(), fd,
+                                  NotifyOn::Read | NotifyOn::Write | NotifyOn::Shutdown,
+                                  Polling::Mode::Edge);
+            armHandshakeTimer(peer->handshakeDeadline_);
+            handleHandshake(peer);
+            return;
+        }
+
+        // Registered once for both directions: whether a write waits for
+        // room in the socket is kept in toWrite, rather than in the poller
+        addPeer(peer);
+        reactor()->registerFd(key(), fd, NotifyOn::Read | NotifyOn::Write | NotifyOn::Shutdown,
+                              Polling::Mode::Edge);
+    }
+
+    void Transport::addPeer(const std::shared_ptr<Peer>& peer)
+    {
+        Fd fd = peer->fd();
+
         {
             // See comment in transport.h on why peers_ must be mutex-protected
             std::lock_guard<std::mutex> l_guard(peers_mutex_);
@@ -1113,13 +1565,126 @@ namespace Pistache::Tcp
             auto auto_insert_res_pr = peers_.insert(std::make_pair(fd, peer));
             if (!auto_insert_res_pr.second)
                 PS_LOG_WARNING_ARGS("Failed to insert peer %p", peer.get());
+            --pendingPeers_;
         }
 
         peer->associateTransport(this);
 
         handler_->onConnection(peer);
-        reactor()->registerFd(key(), fd, NotifyOn::Read | NotifyOn::Shutdown,
-                              Polling::Mode::Edge);
+    }
+
+    void Transport::handleHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+#ifdef PISTACHE_USE_SSL
+        auto* ssl     = static_cast<SSL*>(peer->ssl());
+        const int res = SSL_do_handshake(ssl);
+        if (res == 1)
+        {
+            PS_LOG_DEBUG_ARGS("SSL handshake done, peer %p", peer.get());
+
+            handshakes_.erase(peer->fd());
+            peer->handshakePending_ = false;
+
+            addPeer(peer);
+
+            // The request may have arrived along with the end of the
+            // handshake, in which case no new edge will be reported for it
+            handleIncoming(peer);
+            return;
+        }
+
+        const int err = SSL_get_error(ssl, res);
+        if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+        {
+            PS_LOG_DEBUG_ARGS("SSL handshake in progress, peer %p, want %s", peer.get(),
+                              (err == SSL_ERROR_WANT_READ) ? "read" : "write");
+            return;
+        }
+
+        PS_LOG_INFO_ARGS("SSL handshake failed, peer %p, err %d, last 0x%08X",
+                         peer.get(), err, ERR_peek_last_error());
+
+        char reason[256];
+        ERR_error_string_n(ERR_peek_last_error(), reason, sizeof(reason));
+        PISTACHE_LOG_STRING_INFO(logger_, "SSL connection error: " << reason);
+        ERR_clear_error();
+#endif /* PISTACHE_USE_SSL */
+
+        dropHandshake(peer);
+    }
+
+    void Transport::dropHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        --pendingPeers_;
+
+        Fd fd = peer->fd();
+        if (fd == PS_FD_EMPTY)
+            return;
+
+        handshakes_.erase(fd);
+
+        Aio::Reactor* r = reactor();
+        if (r)
+            r->removeFd(key(), fd);
+
+        peer->closeFd();
+    }
+
+    void Transport::armHandshakeTimer(std::chrono::steady_clock::time_point deadline)
+    {
+        // The timer already fires early enough
+        if (deadline >= handshakeTimerDeadline_)
+            return;
+
+        if (!handshakeTimer_)
+        {
+            handshakeTimer_ = std::make_shared<TimerPool::Entry>();
+            handshakeTimer_->initialize();
+            handshakeTimer_->registerReactor(key(), reactor());
+        }
+
+        // A zero duration would disarm the timer instead
+        const auto delay = std::max(
+            std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()),
+            std::chrono::milliseconds(1));
+
+        handshakeTimer_->arm(delay);
+        handshakeTimerDeadline_ = deadline;
+    }
+
+    void Transport::handleHandshakeTimer()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        uint64_t wakeups;
+        [[maybe_unused]] auto rv = READ_FD(handshakeTimer_->fd(), &wakeups, sizeof wakeups);
+
+        const auto now = std::chrono::steady_clock::now();
+        auto next      = std::chrono::steady_clock::time_point::max();
+
+        std::vector<std::shared_ptr<Peer>> expired;
+        for (const auto& handshake : handshakes_)
+        {
+            const auto deadline = handshake.second->handshakeDeadline_;
+            if (deadline <= now)
+                expired.push_back(handshake.second);
+            else
+                next = std::min(next, deadline);
+        }
+
+        for (const auto& peer : expired)
+        {
+            PS_LOG_DEBUG_ARGS("SSL handshake timed out, peer %p", peer.get());
+            dropHandshake(peer);
+        }
+
+        // The timer may also have fired early, since it has a granularity of
+        // one second for delays longer than that
+        handshakeTimerDeadline_ = std::chrono::steady_clock::time_point::max();
+        if (next != std::chrono::steady_clock::time_point::max())
+            armHandshakeTimer(next);
     }
 
     void Transport::handleNotify()
@@ -1240,7 +1805,19 @@ namespace Pistache::Tcp
         return it->second;
     }
 
-    std::shared_ptr<Peer> Transport::getPeer(Polling::Tag tag)
+    std::shared_ptr<Peer> Transport::findPeer(FdConst fdconst) const
+    {
+        // Can cast away const since we're not actually going to change fd
+        Fd fd = PS_CAST_AWAY_CONST_FD(fdconst);
+
+        // See comment in transport.h on why peers_ must be mutex-protected
+        std::lock_guard<std::mutex> l_guard(peers_mutex_);
+
+        auto it = peers_.find(fd);
+        return it != std::end(peers_) ? it->second : nullptr;
+    }
+
+        std::shared_ptr<Peer> Transport::getPeer(Polling::Tag tag)
     {
         return getPeer(static_cast<FdConst>(tag.value()));
     }
@@ -1265,4 +1842,11 @@ namespace Pistache::Tcp
         return dqPeers;
     }
 
+    size_t Transport::peerCount() const
+    {
+        // See comment in transport.h on why peers_ must be mutex-protected
+        std::lock_guard<std::mutex> l_guard(peers_mutex_);
+        return peers_.size() + pendingPeers_.load();
+    }
+
 } // namespace Pistache::Tcp
@@ -15,13 +15,25 @@
 #include <pistache/peer.h>
 #include <pistache/pist_quote.h>
 #include <pistache/tcp.h>
+#include <pistache/timer_wheel.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace Pistache::Http
 {
 
+    namespace
+    {
+        // Period of the timer advancing the timeout wheel, which is also
+        // the resolution of the header, body and keep-alive timeouts
+        constexpr auto TimerInterval = std::chrono::milliseconds(500);
+    }
+
     class TransportImpl : public Tcp::Transport
     {
     public:
@@ -35,29 +47,46 @@ namespace Pistache::Http
 
         void onReady(const Aio::FdSet& fds) override;
 
+        void touchPeer(const std::shared_ptr<Tcp::Peer>& peer) override;
+
         void setHeaderTimeout(std::chrono::milliseconds timeout);
         void setBodyTimeout(std::chrono::milliseconds timeout);
         void setKeepaliveTimeout(std::chrono::milliseconds timeout);
+        void setConnectionSoftLimit(size_t limit);
 
         std::shared_ptr<Aio::Handler> clone() const override;
 
+    protected:
+        void forgetPeer(const std::shared_ptr<Tcp::Peer>& peer) override;
+
     private:
+        using Clock = std::chrono::steady_clock;
+
         std::shared_ptr<Tcp::Handler> handler_;
         std::chrono::milliseconds headerTimeout_;
         std::chrono::milliseconds bodyTimeout_;
         std::chrono::milliseconds keepaliveTimeout_;
+        size_t connectionSoftLimit_ = 0;
 
         Fd timerFd;
 
-        void checkIdlePeers();
-        bool checkTimeout(bool idle, Private::StepId id, std::chrono::milliseconds elapsed);
+        // Deadline of every peer, advanced by timerFd. Peers are scheduled
+        // again whenever their state changes, see touchPeer(), so that a
+        // tick only deals with the peers that actually time out.
+        std::mutex wheelMutex_;
+        TimerWheel<Fd> wheel_;
+
+        void expirePeers();
+        std::optional<Clock::time_point> deadline(const std::shared_ptr<Tcp::Peer>& peer) const;
         void closePeer(std::shared_ptr<Tcp::Peer>& peer);
+        void shedIdlePeers();
     };
 
     TransportImpl::TransportImpl(const std::shared_ptr<Tcp::Handler>& handler)
         : Tcp::Transport(handler)
         , handler_(handler)
         , timerFd(PS_FD_EMPTY)
+        , wheel_(TimerInterval)
     { }
 
     TransportImpl::~TransportImpl()
@@ -84,7 +113,6 @@ namespace Pistache::Http
             TRY_RET(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK));
 #endif
 
-        static constexpr auto TimerInterval   = std::chrono::milliseconds(500);
         static constexpr auto TimerIntervalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(TimerInterval);
 
         static_assert(
@@ -152,7 +180,9 @@ namespace Pistache::Http
                 PS_LOG_DEBUG_ARGS("timerFd %p had %u wakeup%s",
                                   timerFd, wakeups, (wakeups == 1) ? "" : "s");
 
-                checkIdlePeers();
+                expirePeers();
+                if (connectionSoftLimit_ != 0)
+                    shedIdlePeers();
                 break;
             }
         }
@@ -172,29 +202,76 @@ namespace Pistache::Http
     {
         keepaliveTimeout_ = timeout;
     }
+    void TransportImpl::setConnectionSoftLimit(size_t limit)
+    {
+        connectionSoftLimit_ = limit;
+    }
 
-    void TransportImpl::checkIdlePeers()
+    void TransportImpl::touchPeer(const std::shared_ptr<Tcp::Peer>& peer)
     {
-        std::vector<std::shared_ptr<Tcp::Peer>> idlePeers;
+        Fd fd = peer->fd();
+        if (fd == PS_FD_EMPTY)
+            return;
+
+        // A peer turns idle when its response is sent, possibly from
+        // another thread than the transport's, so the parser is left alone
+        // then. The keep-alive timeout is simply counted from now.
+        std::optional<Clock::time_point> when;
+        if (peer->isIdle())
+            when = Clock::now() + keepaliveTimeout_;
+        else
+            when = deadline(peer);
 
+        std::lock_guard<std::mutex> guard(wheelMutex_);
+        if (when)
+            wheel_.schedule(fd, *when);
+        else
+            wheel_.cancel(fd);
+    }
+
+    void TransportImpl::forgetPeer(const std::shared_ptr<Tcp::Peer>& peer)
+    {
+        std::lock_guard<std::mutex> guard(wheelMutex_);
+        wheel_.cancel(peer->fd());
+    }
+
+    void TransportImpl::expirePeers()
+    {
+        auto now = Clock::now();
+
+        std::vector<Fd> expired;
         {
-            // See comment in transport.h on why peers_ must be mutex-protected
-            std::lock_guard<std::mutex> l_guard(peers_mutex_);
-            for (const auto& peerPair : peers_)
+            std::lock_guard<std::mutex> guard(wheelMutex_);
+            wheel_.advance(now, expired);
+        }
+
+        std::vector<std::shared_ptr<Tcp::Peer>> idlePeers;
+        for (Fd fd : expired)
+        {
+            std::shared_ptr<Tcp::Peer> peer;
+            {
+                // See comment in transport.h on why peers_ must be mutex-protected
+                std::lock_guard<std::mutex> l_guard(peers_mutex_);
+                auto it = peers_.find(fd);
+                if (it == peers_.end())
+                    continue;
+                peer = it->second;
+            }
+
+            // The parser may have moved on without the peer being touched,
+            // e.g. from the headers to the body
+            auto when = deadline(peer);
+            if (!when)
+                continue;
+            if (*when > now)
             {
-                const auto& peer = peerPair.second;
-                auto parser      = Http::Handler::getParser(peer);
-                auto time        = parser->time();
-
-                auto now     = std::chrono::steady_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - time);
-
-                auto* step = parser->step();
-                if (checkTimeout(peer->isIdle(), step->id(), elapsed))
-                {
-                    idlePeers.push_back(peer);
-                }
+                std::lock_guard<std::mutex> guard(wheelMutex_);
+                if (!wheel_.contains(fd))
+                    wheel_.schedule(fd, *when);
+                continue;
             }
+
+            idlePeers.push_back(peer);
         }
 
         for (auto& idlePeer : idlePeers)
@@ -202,28 +279,61 @@ namespace Pistache::Http
             closePeer(idlePeer);
         }
     }
-    bool TransportImpl::checkTimeout(bool idle, Private::StepId id, std::chrono::milliseconds elapsed)
+
+    void TransportImpl::shedIdlePeers()
     {
-        if (idle)
+        // Idle peers, by the time their last request came in
+        std::vector<std::pair<Clock::time_point, std::shared_ptr<Tcp::Peer>>> idle;
+        size_t excess = 0;
         {
-            return elapsed > keepaliveTimeout_;
-        }
-        else
-        {
-            if (id == Private::RequestLineStep::Id || id == Private::HeadersStep::Id)
-            {
-                return elapsed > headerTimeout_ || elapsed > bodyTimeout_;
-            }
-            else if (id == Private::BodyStep::Id)
-            {
-                return elapsed > bodyTimeout_;
-            }
-            else
+            std::lock_guard<std::mutex> l_guard(peers_mutex_);
+            if (peers_.size() <= connectionSoftLimit_)
+                return;
+
+            excess = peers_.size() - connectionSoftLimit_;
+            for (const auto& entry : peers_)
             {
-                return false;
+                const auto& peer = entry.second;
+                if (!peer || !peer->isIdle())
+                    continue;
+
+                if (auto parser = Http::Handler::getParser(peer))
+                    idle.emplace_back(parser->time(), peer);
             }
         }
+
+        excess = std::min(excess, idle.size());
+        std::partial_sort(idle.begin(), idle.begin() + static_cast<std::ptrdiff_t>(excess),
+                          idle.end(),
+                          [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+        PS_LOG_DEBUG_ARGS("Closing %u idle peers over the soft limit",
+                          static_cast<unsigned>(excess));
+
+        for (size_t i = 0; i < excess; ++i)
+            removePeer(idle[i].second);
     }
+
+    std::optional<std::chrono::steady_clock::time_point>
+    TransportImpl::deadline(const std::shared_ptr<Tcp::Peer>& peer) const
+    {
+        auto parser = Http::Handler::getParser(peer);
+        if (!parser)
+            return std::nullopt;
+
+        auto time = parser->time();
+        if (peer->isIdle())
+            return time + keepaliveTimeout_;
+
+        auto id = parser->step()->id();
+        if (id == Private::RequestLineStep::Id || id == Private::HeadersStep::Id)
+            return time + std::min(headerTimeout_, bodyTimeout_);
+        if (id == Private::BodyStep::Id)
+            return time + bodyTimeout_;
+
+        return std::nullopt;
+    }
+
     void TransportImpl::closePeer(std::shared_ptr<Tcp::Peer>& peer)
     {
         PS_TIMEDBG_START_THIS;
@@ -236,7 +346,10 @@ namespace Pistache::Http
         }
         else
         {
-            ResponseWriter response(Http::Version::Http11, this, static_cast<Http::Handler*>(handler_.get()), peer);
+            // After the responses to the requests read in full
+            auto turn = std::make_shared<Http::Private::ResponseTurn>(
+                Http::Handler::getParser(peer)->responses);
+            ResponseWriter response(Http::Version::Http11, this, static_cast<Http::Handler*>(handler_.get()), peer, std::move(turn));
             response.send(Http::Code::Request_Timeout).then([peer, this](PST_SSIZE_T) { removePeer(peer); }, [peer, this](std::exception_ptr) { removePeer(peer); });
         }
     }
@@ -247,6 +360,8 @@ namespace Pistache::Http
         transport->setHeaderTimeout(headerTimeout_);
         transport->setBodyTimeout(bodyTimeout_);
         transport->setKeepaliveTimeout(keepaliveTimeout_);
+        transport->setConnectionSoftLimit(connectionSoftLimit_);
+        transport->setReadBudget(readBudget());
         return transport;
     }
 
@@ -262,6 +377,19 @@ namespace Pistache::Http
         , logger_(PISTACHE_NULL_STRING_LOGGER)
         // This should be moved after "keepaliveTimeout_" in the next ABI change
         , sslHandshakeTimeout_(Const::DefaultSSLHandshakeTimeout)
+        , lazyHeaders_(false)
+        , dateHeader_(false)
+        , serverHeader_()
+        , maxRequestsPerConnection_(0)
+        , connectionSoftLimit_(0)
+        , reusePortAcceptors_(false)
+        , incomingCpu_(false)
+        , dispatchPolicy_(Tcp::Listener::DispatchPolicy::Default)
+        , acceptBudget_(Const::DefaultAcceptBudget)
+        , receiveBufferSize_(0)
+        , sendBufferSize_(0)
+        , resolveHostnames_(false)
+        , readBudget_(Const::DefaultReadBudget)
     { }
 
     Endpoint::Options& Endpoint::Options::threads(int val)
@@ -305,6 +433,75 @@ namespace Pistache::Http
         return *this;
     }
 
+    Endpoint::Options& Endpoint::Options::lazyHeaders(bool val)
+    {
+        lazyHeaders_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::dateHeader(bool val)
+    {
+        dateHeader_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::serverHeader(std::string val)
+    {
+        serverHeader_ = std::move(val);
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::maxRequestsPerConnection(size_t val)
+    {
+        maxRequestsPerConnection_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::connectionSoftLimit(size_t val)
+    {
+        connectionSoftLimit_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::reusePortAcceptors(bool val, bool incomingCpu)
+    {
+        reusePortAcceptors_ = val;
+        incomingCpu_        = incomingCpu;
+        return *this;
+    }
+
+    Endpoint::Options&
+    Endpoint::Options::dispatchPolicy(Tcp::Listener::DispatchPolicy val)
+    {
+        dispatchPolicy_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::acceptBudget(size_t val)
+    {
+        acceptBudget_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::socketBufferSizes(size_t receive, size_t send)
+    {
+        receiveBufferSize_ = receive;
+        sendBufferSize_    = send;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::resolveHostnames(bool val)
+    {
+        resolveHostnames_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::readBudget(size_t val)
+    {
+        readBudget_ = val;
+        return *this;
+    }
+
     Endpoint::Options& Endpoint::Options::logger(PISTACHE_STRING_LOGGER_T logger)
     {
         logger_ = logger;
@@ -319,7 +516,13 @@ namespace Pistache::Http
 
     void Endpoint::init(const Endpoint::Options& options)
     {
-        listener.init(options.threads_, options.flags_, options.threadsName_, options.backlog_);
+        listener.init(options.threads_, options.flags_, options.threadsName_, options.backlog_,
+                      options.logger_);
+        listener.setReusePortAcceptors(options.reusePortAcceptors_, options.incomingCpu_);
+        listener.setDispatchPolicy(options.dispatchPolicy_);
+        listener.setAcceptBudget(options.acceptBudget_);
+        listener.setSocketBufferSizes(options.receiveBufferSize_, options.sendBufferSize_);
+        listener.setResolveHostnames(options.resolveHostnames_);
         listener.setTransportFactory([this, options] {
             if (!handler_)
                 throw std::runtime_error("Must call setHandler()");
@@ -328,6 +531,8 @@ namespace Pistache::Http
             transport->setHeaderTimeout(options.headerTimeout_);
             transport->setBodyTimeout(options.bodyTimeout_);
             transport->setKeepaliveTimeout(options.keepaliveTimeout_);
+            transport->setConnectionSoftLimit(options.connectionSoftLimit_);
+            transport->setReadBudget(options.readBudget_);
 
             return transport;
         });
@@ -336,6 +541,10 @@ namespace Pistache::Http
         {
             handler_->setMaxRequestSize(options.maxRequestSize_);
             handler_->setMaxResponseSize(options.maxResponseSize_);
+            handler_->setLazyHeaders(options.lazyHeaders_);
+            handler_->setDateHeader(options.dateHeader_);
+            handler_->setServerHeader(options.serverHeader_);
+            handler_->setMaxRequestsPerConnection(options.maxRequestsPerConnection_);
         }
 
         options_ = options;
@@ -347,6 +556,10 @@ namespace Pistache::Http
         handler_ = handler;
         handler_->setMaxRequestSize(options_.maxRequestSize_);
         handler_->setMaxResponseSize(options_.maxResponseSize_);
+        handler_->setLazyHeaders(options_.lazyHeaders_);
+        handler_->setDateHeader(options_.dateHeader_);
+        handler_->setServerHeader(options_.serverHeader_);
+        handler_->setMaxRequestsPerConnection(options_.maxRequestsPerConnection_);
     }
 
     void Endpoint::bind() { listener.bind(); }
@@ -44,8 +44,17 @@
 
 #include <sys/types.h>
 
+#if defined(__linux__) && !defined(_USE_LIBEVENT)
+#include <linux/filter.h>
+// Each worker polls its own SO_REUSEPORT listening socket
+#define PST_REUSEPORT_ACCEPTORS 1
+#endif
+
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -279,6 +288,17 @@ namespace Pistache::Tcp
                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&one),
                 sizeof(one)));
         }
+#ifdef TCP_DEFER_ACCEPT
+        if (options.hasFlag(Options::DeferAccept))
+        {
+            PST_SOCK_OPT_VAL_TYPICAL_T seconds = static_cast<PST_SOCK_OPT_VAL_TYPICAL_T>(
+                std::chrono::seconds(Const::DeferAcceptTimeout).count());
+            TRY(::setsockopt(
+                actualFd, tcp_prot_num, TCP_DEFER_ACCEPT,
+                reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&seconds),
+                sizeof(seconds)));
+        }
+#endif
     }
 
     Listener::Listener()
@@ -297,6 +317,16 @@ namespace Pistache::Tcp
         if (acceptThread.joinable())
             acceptThread.join();
 
+        if (!acceptorFds_.empty())
+        {
+            // The workers accept through this listener, stop them first
+            reactor_.reset();
+
+            for (Fd fd : acceptorFds_)
+                CLOSE_FD(fd);
+            acceptorFds_.clear();
+        }
+
         if (listen_fd != PS_FD_EMPTY)
         {
             CLOSE_FD(listen_fd);
@@ -331,6 +361,103 @@ namespace Pistache::Tcp
         handler_ = handler;
     }
 
+    void Listener::setReusePortAcceptors(bool enable, bool incomingCpu)
+    {
+#ifdef PST_REUSEPORT_ACCEPTORS
+        reusePortAcceptors_ = enable;
+        incomingCpu_        = enable && incomingCpu;
+#else
+        if (enable)
+            PS_LOG_WARNING("SO_REUSEPORT acceptors not supported, using a single accept thread");
+        reusePortAcceptors_ = false;
+        incomingCpu_        = false;
+        (void)incomingCpu;
+#endif
+    }
+
+    void Listener::setAcceptBudget(size_t budget)
+    {
+        acceptBudget_ = std::max<size_t>(budget, 1);
+    }
+
+    void Listener::setSocketBufferSizes(size_t receive, size_t send)
+    {
+        receiveBufferSize_ = receive;
+        sendBufferSize_    = send;
+    }
+
+    void Listener::setResolveHostnames(bool enable) { resolveHostnames_ = enable; }
+
+    Listener::AcceptStats Listener::acceptStats() const
+    {
+        AcceptStats stats;
+        stats.accepted = accepted_.load(std::memory_order_relaxed);
+
+#ifdef __linux__
+        // On a listening socket, tcpi_unacked is the length of the accept
+        // queue and tcpi_sacked its capacity
+        auto addQueue = [&stats](em_socket_t fd) {
+            struct tcp_info info = {};
+            socklen_t len        = sizeof(info);
+            if (::getsockopt(fd, SOL_TCP, TCP_INFO, &info, &len) == 0)
+            {
+                stats.queued += info.tcpi_unacked;
+                stats.backlog += info.tcpi_sacked;
+            }
+        };
+
+        if (!acceptorFds_.empty())
+        {
+            for (Fd fd : acceptorFds_)
+                addQueue(GET_ACTUAL_FD(fd));
+        }
+        else if (listen_fd != PS_FD_EMPTY)
+        {
+            addQueue(GET_ACTUAL_FD(listen_fd));
+        }
+
+        // Header and value lines alternate, one pair per protocol
+        std::ifstream netstat("/proc/net/netstat");
+        std::string names;
+        std::string values;
+        while (std::getline(netstat, names) && std::getline(netstat, values))
+        {
+            if (names.rfind("TcpExt:", 0) != 0)
+                continue;
+
+            std::istringstream nameStream(names);
+            std::istringstream valueStream(values);
+            std::string name;
+            uint64_t value = 0;
+
+            // Skips the "TcpExt:" prefixes
+            nameStream >> name;
+            valueStream >> name;
+
+            while (nameStream >> name && valueStream >> value)
+            {
+                if (name == "ListenOverflows")
+                    stats.listenOverflows = value;
+                else if (name == "ListenDrops")
+                    stats.listenDrops = value;
+            }
+            break;
+        }
+#endif
+
+        return stats;
+    }
+
+    void Listener::setDispatchPolicy(DispatchPolicy policy)
+    {
+        dispatchPolicy_ = policy;
+    }
+
+    Listener::DispatchPolicy Listener::dispatchPolicy() const
+    {
+        return dispatchPolicy_;
+    }
+
     void Listener::pinWorker([[maybe_unused]] size_t worker, [[maybe_unused]] const CpuSet& set)
     {
 #if 0
@@ -382,7 +509,15 @@ namespace Pistache::Tcp
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
-        setSocketOptions(actual_fd, options_);
+        // With per-worker acceptors, this socket only reserves the address:
+        // it is bound but never listens, so that the kernel only spreads
+        // connections over the workers' sockets
+        auto options = options_;
+        if (reusePortAcceptors_)
+            options.setFlag(Options::ReusePort);
+
+        setSocketOptions(actual_fd, options);
+        setBufferSizes(actual_fd);
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
@@ -398,7 +533,8 @@ namespace Pistache::Tcp
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
-        TRY(PST_SOCK_LISTEN(actual_fd, backlog_));
+        if (!reusePortAcceptors_)
+            TRY(PST_SOCK_LISTEN(actual_fd, backlog_));
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
@@ -428,10 +564,16 @@ namespace Pistache::Tcp
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
-        PS_LOG_DEBUG_ARGS("Add read fd %" PIST_QUOTE(PS_FD_PRNTFCD), event_fd);
-        poller.addFd(event_fd,
-                     Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
-                     Polling::Tag(event_fd));
+        // A bound socket that does not listen reports a hang-up on every
+        // poll, so the reserving socket of per-worker acceptors is kept out
+        // of the poller: the workers watch their own sockets
+        if (!reusePortAcceptors_)
+        {
+            PS_LOG_DEBUG_ARGS("Add read fd %" PIST_QUOTE(PS_FD_PRNTFCD), event_fd);
+            poller.addFd(event_fd,
+                         Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
+                         Polling::Tag(event_fd));
+        }
         listen_fd = event_fd;
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
@@ -443,11 +585,93 @@ namespace Pistache::Tcp
 
         transportKey = reactor_->addHandler(transport);
 
+        for (const auto& handler : reactor_->handlers(transportKey))
+            std::static_pointer_cast<Transport>(handler)->setLogger(logger_);
+
+        if (reusePortAcceptors_)
+            bindAcceptors(addr);
+
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
         return true;
     }
 
+    void Listener::bindAcceptors([[maybe_unused]] const struct addrinfo* addr)
+    {
+        PS_TIMEDBG_START_THIS;
+
+#ifdef PST_REUSEPORT_ACCEPTORS
+        // Bind to the address actually reserved by listen_fd, which carries
+        // the port picked by the kernel if port 0 was requested
+        struct sockaddr_storage bound = {};
+        socklen_t boundLen            = sizeof(bound);
+        TRY(::getsockname(listen_fd, reinterpret_cast<struct sockaddr*>(&bound), &boundLen));
+
+        auto options = options_;
+        options.setFlag(Options::ReusePort);
+
+        auto socktype = addr->ai_socktype;
+        if (options_.hasFlag(Options::CloseOnExec))
+            socktype |= SOCK_CLOEXEC;
+
+        const auto handlers = reactor_->handlers(transportKey);
+        for (const auto& handler : handlers)
+        {
+            const int fd = TRY_RET(::socket(addr->ai_family, socktype, addr->ai_protocol));
+            acceptorFds_.push_back(fd);
+
+            setSocketOptions(fd, options);
+            setBufferSizes(fd);
+            TRY(::bind(fd, reinterpret_cast<struct sockaddr*>(&bound), boundLen));
+            TRY(::listen(fd, backlog_));
+            make_non_blocking(fd);
+
+            auto transport = std::static_pointer_cast<Transport>(handler);
+            transport->setAcceptor(
+                fd, [this](Fd listenFd) { return acceptPeer(listenFd); }, acceptBudget_);
+        }
+
+        if (incomingCpu_)
+        {
+            // Sockets are indexed in the order they started listening, so
+            // returning cpu % workers picks the socket of that worker
+            struct sock_filter code[] = {
+                { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+                { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(handlers.size()) },
+                { BPF_RET | BPF_A, 0, 0, 0 },
+            };
+
+            struct sock_fprog prog = {};
+            prog.len               = sizeof(code) / sizeof(code[0]);
+            prog.filter            = code;
+
+            TRY(::setsockopt(acceptorFds_.front(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                             &prog, sizeof(prog)));
+        }
+#endif /* PST_REUSEPORT_ACCEPTORS */
+    }
+
+    void Listener::setBufferSizes(em_socket_t actualFd) const
+    {
+        // Set before listen(), so that the window scale offered to clients
+        // accounts for the receive buffer
+        if (receiveBufferSize_ != 0)
+        {
+            auto size = static_cast<PST_SOCK_OPT_VAL_TYPICAL_T>(receiveBufferSize_);
+            TRY(::setsockopt(actualFd, SOL_SOCKET, SO_RCVBUF,
+                             reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&size),
+                             sizeof(size)));
+        }
+
+        if (sendBufferSize_ != 0)
+        {
+            auto size = static_cast<PST_SOCK_OPT_VAL_TYPICAL_T>(sendBufferSize_);
+            TRY(::setsockopt(actualFd, SOL_SOCKET, SO_SNDBUF,
+                             reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&size),
+                             sizeof(size)));
+        }
+    }
+
     void Listener::bind(const Address& address)
     {
         PS_TIMEDBG_START_THIS;
@@ -463,6 +687,9 @@ namespace Pistache::Tcp
 
         if (family == AF_UNIX)
         {
+            // A unix socket path can only be bound once
+            reusePortAcceptors_ = false;
+
             const struct sockaddr& sa = address.getSockAddr();
             // unix domain sockets are confined to the local host, so there's
             // no question of finding the best address.  It's simply the one
@@ -686,6 +913,13 @@ namespace Pistache::Tcp
                         res.global /= static_cast<double>(usages.size());
                     }
 
+                    // Weighs the peer counts of the load-aware dispatch
+                    // policies
+                    {
+                        std::lock_guard<std::mutex> guard(dispatchLoadMutex_);
+                        dispatchLoad_ = res.workers;
+                    }
+
                     return res;
                 },
                 Async::Throw);
@@ -699,8 +933,30 @@ namespace Pistache::Tcp
     {
         PS_TIMEDBG_START_THIS;
 
+        // A burst of connections is taken in with one poll, up to the
+        // budget. The listening socket is level-triggered, so whatever is
+        // left is reported again on the next poll.
+        for (size_t i = 0; i < acceptBudget_; ++i)
+        {
+            auto peer = acceptPeer(listen_fd);
+            if (!peer)
+                return;
+
+            PS_LOG_DEBUG_ARGS("Calling dispatchPeer %p", peer.get());
+            dispatchPeer(peer);
+        }
+    }
+
+    std::shared_ptr<Peer> Listener::acceptPeer(Fd listenFd)
+    {
+        PS_TIMEDBG_START_THIS;
+
         struct sockaddr_storage peer_addr;
-        em_socket_t actual_cli_fd = acceptConnection(peer_addr);
+        em_socket_t actual_cli_fd = acceptConnection(listenFd, peer_addr);
+        if (actual_cli_fd < 0)
+            return nullptr;
+
+        accepted_.fetch_add(1, std::memory_order_relaxed);
 
         void* ssl = nullptr;
 
@@ -720,49 +976,6 @@ namespace Pistache::Tcp
                 throw ServerError(err.c_str());
             }
 
-            // If user requested SSL handshake timeout, enable it on the
-            //  socket.  This is sometimes necessary if a client connects,
-            //  sends nothing, or possibly refuses to accept any bytes, and
-            //  never completes a handshake. This would have left SSL_accept
-            //  hanging indefinitely and is effectively a DoS...
-            if (sslHandshakeTimeout_ > 0ms)
-            {
-                PS_LOG_DEBUG("SSL timeout to be set");
-
-#ifdef _IS_WINDOWS
-
-                unsigned long int timeout_in_ms =
-                    static_cast<unsigned long int>(
-                        std::chrono::duration_cast<
-                        std::chrono::milliseconds>(sslHandshakeTimeout_)
-                        .count());
-
-                PS_LOG_DEBUG_ARGS("Socket timeout %dms", timeout_in_ms);
-
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_RCVTIMEO,
-                                          timeout_in_ms));
-
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_SNDTIMEO,
-                                          timeout_in_ms));
-
-#else
-
-                struct timeval timeout;
-
-                timeout.tv_sec = static_cast<PST_TIMEVAL_S_T>(std::chrono::duration_cast<std::chrono::seconds>(sslHandshakeTimeout_).count());
-
-                const auto residual_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(sslHandshakeTimeout_) - std::chrono::duration_cast<std::chrono::seconds>(sslHandshakeTimeout_);
-                timeout.tv_usec                  = static_cast<PST_SUSECONDS_T>(residual_microseconds.count());
-
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_RCVTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_SNDTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-#endif // Of ifdef _IS_WINDOWS... else...
-            }
-
             SSL_set_fd(ssl_data,
 #ifdef _IS_WINDOWS
                        // SSL_set_fd takes type int for the FD parm, resulting
@@ -780,61 +993,13 @@ namespace Pistache::Tcp
             );
             SSL_set_accept_state(ssl_data);
 
-            PS_LOG_DEBUG_ARGS("Calling SSL_accept with ssl_data %p", ssl_data);
-            int ssl_accept_res = SSL_accept(ssl_data);
-
-            if (ssl_accept_res <= 0)
-            {
-                PS_LOG_DEBUG_ARGS("SSL_accept failed, ssl_accept_res %d, "
-                                  "actual_cli_fd %d",
-                                  ssl_accept_res, actual_cli_fd);
-
-#ifdef DEBUG
-                const char* ssl_ver = OPENSSL_VERSION_TEXT;
-                PS_LOG_DEBUG_ARGS("openssl: %s", ssl_ver);
-
-                int ssl_err_code = SSL_get_error(ssl_data, ssl_accept_res);
-#endif
-                std::string err = "SSL connection error: "
-                    + ssl_print_errors_to_string();
-                PS_LOG_DEBUG_ARGS("ssl_err_code %d, %s",
-                                  ssl_err_code, err.c_str());
-                PISTACHE_LOG_STRING_INFO(logger_, err);
-
-                PS_LOG_DEBUG("ssl_accept failed");
-                SSL_free(ssl_data);
-                PST_SOCK_CLOSE(actual_cli_fd);
-                return;
-            }
-
-            PS_LOG_DEBUG("SSL_accept succcess");
-
-            // Remove socket timeouts if they were enabled now that we have
-            //  handshaked...
-            if (sslHandshakeTimeout_ > 0ms)
-            {
-                PS_LOG_DEBUG("SSL timeout to be removed");
-
-#ifdef _IS_WINDOWS
-
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_RCVTIMEO, 0));
-                TRY(pist_sock_set_timeout(actual_cli_fd, SO_SNDTIMEO, 0));
-
-#else
-
-                struct timeval timeout;
-                timeout.tv_sec  = 0;
-                timeout.tv_usec = 0;
-
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_RCVTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_SNDTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_PTR_T>(&timeout),
-                                 sizeof(timeout)));
-
-#endif // Of ifdef _IS_WINDOWS... else...
-            }
+            // The handshake itself is not done here: a client that connects
+            // and then sends nothing, or refuses to read, would otherwise
+            // stall every other incoming connection. It is driven without
+            // blocking by the worker Transport the peer is dispatched to,
+            // which closes the connection if the handshake has not completed
+            // within sslHandshakeTimeout_
+            PS_LOG_DEBUG_ARGS("SSL handshake deferred, ssl_data %p", ssl_data);
 
             ssl = static_cast<void*>(ssl_data);
         }
@@ -845,8 +1010,12 @@ namespace Pistache::Tcp
             PS_LOG_WARNING_ARGS("actual_cli_fd %d failed make_non_blocking",
                                 actual_cli_fd);
 
+#ifdef PISTACHE_USE_SSL
+            if (ssl != nullptr)
+                SSL_free(static_cast<SSL*>(ssl));
+#endif /* PISTACHE_USE_SSL */
             PST_SOCK_CLOSE(actual_cli_fd);
-            return;
+            return nullptr;
         }
 
 #ifdef _USE_LIBEVENT
@@ -869,6 +1038,10 @@ namespace Pistache::Tcp
             PS_LOG_DEBUG("Calling Peer::CreateSSL");
 
             peer = Peer::CreateSSL(client_fd, Address::fromUnix(peer_alias), ssl);
+
+            peer->handshakePending_ = true;
+            if (sslHandshakeTimeout_ > 0ms)
+                peer->handshakeDeadline_ = std::chrono::steady_clock::now() + sslHandshakeTimeout_;
         }
         else
         {
@@ -877,21 +1050,26 @@ namespace Pistache::Tcp
             peer = Peer::Create(client_fd, Address::fromUnix(peer_alias));
         }
 
-        PS_LOG_DEBUG_ARGS("Calling dispatchPeer %p", peer.get());
-        dispatchPeer(peer);
+        // The name is then usually cached by the time the handler asks
+        // for it, and hostname() does not block
+        if (resolveHostnames_)
+            peer->resolveHostname();
+
+        return peer;
     }
 
-    em_socket_t Listener::acceptConnection(struct sockaddr_storage& peer_addr) const
+    em_socket_t Listener::acceptConnection(Fd listenFd,
+                                           struct sockaddr_storage& peer_addr) const
     {
         PS_TIMEDBG_START_THIS;
 
         socklen_t peer_addr_len = sizeof(peer_addr);
 
-        em_socket_t listen_fd_actual = GET_ACTUAL_FD(listen_fd);
+        em_socket_t listen_fd_actual = GET_ACTUAL_FD(listenFd);
 
-        PS_LOG_DEBUG_ARGS("listen_fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
-                                                                  "listen_fd_actual %d",
-                          listen_fd, listen_fd_actual);
+        PS_LOG_DEBUG_ARGS("listenFd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
+                                                                 "listen_fd_actual %d",
+                          listenFd, listen_fd_actual);
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(listen_fd_actual);
 
@@ -932,6 +1110,10 @@ namespace Pistache::Tcp
 
         if (client_actual_fd < 0)
         {
+            // The queue has been drained
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return -1;
+
             PS_LOG_DEBUG("socket accept failed");
 
             PST_DECL_SE_ERR_P_EXTRA;
@@ -1023,10 +1205,64 @@ namespace Pistache::Tcp
             return;
         }
 
+        auto handlers  = reactor_->handlers(transportKey);
+        auto idx       = pickWorker(handlers, actual_fd);
+        auto transport = std::static_pointer_cast<Transport>(handlers[idx]);
+
+        transport->handleNewPeer(peer);
+    }
+
+    size_t Listener::pickWorker(const std::vector<std::shared_ptr<Aio::Handler>>& handlers,
+                                em_socket_t actualFd)
+    {
+        const size_t n = handlers.size();
+        if (n == 1)
+            return 0;
+
+        switch (dispatchPolicy_)
+        {
+        case DispatchPolicy::RoundRobin:
+            return dispatchCtr_++ % n;
+
+        case DispatchPolicy::LeastConnections:
+        {
+            // Start the scan at a rotating position so that ties, e.g. when
+            // all the workers are idle, do not all land on the first worker
+            size_t start = dispatchCtr_++ % n;
+            size_t best  = start;
+            double cost  = workerCost(handlers, start);
+            for (size_t i = 1; i < n; ++i)
+            {
+                size_t idx = (start + i) % n;
+                double c   = workerCost(handlers, idx);
+                if (c < cost)
+                {
+                    best = idx;
+                    cost = c;
+                }
+            }
+            return best;
+        }
+
+        case DispatchPolicy::PowerOfTwoChoices:
+        {
+            // Only called from the accept thread, so the generator needs no
+            // locking
+            size_t first  = dispatchRng_() % n;
+            size_t second = dispatchRng_() % (n - 1);
+            if (second >= first)
+                ++second;
+            return workerCost(handlers, second) < workerCost(handlers, first) ? second : first;
+        }
+
+        case DispatchPolicy::Default:
+            break;
+        }
+
         em_socket_t input_for_idx = 0;
 #ifdef _IS_WINDOWS
-        // actual_fd in Windows seems to be a multiple of 4, so we'll fail to
-        // use a bunch of handlers if we just do "idx = actual_fd %
+        // actualFd in Windows seems to be a multiple of 4, so we'll fail to
+        // use a bunch of handlers if we just do "idx = actualFd %
         // handlers.size()". For instance, if handlers.size() is 4, idx will
         // always be zero. We use a monotonic and atomic counter here instead
         // of the file handle divided by 4, since there is no guarantee that
@@ -1044,14 +1280,25 @@ namespace Pistache::Tcp
             input_for_idx = this_ctr;
         }
 #else
-        input_for_idx = actual_fd;
+        input_for_idx = actualFd;
 #endif
 
-        auto handlers  = reactor_->handlers(transportKey);
-        auto idx       = input_for_idx % handlers.size();
+        return static_cast<size_t>(input_for_idx) % n;
+    }
+
+    double Listener::workerCost(const std::vector<std::shared_ptr<Aio::Handler>>& handlers,
+                                size_t idx) const
+    {
         auto transport = std::static_pointer_cast<Transport>(handlers[idx]);
+        auto peers     = static_cast<double>(transport->peerCount());
 
-        transport->handleNewPeer(peer);
+        std::lock_guard<std::mutex> guard(dispatchLoadMutex_);
+        if (idx >= dispatchLoad_.size())
+            return peers;
+
+        // Count the connection about to be dispatched so that the load still
+        // breaks ties between workers without any peer
+        return (peers + 1.0) * (1.0 + dispatchLoad_[idx] / 100.0);
     }
 
     Listener::TransportFactory Listener::defaultTransportFactory() const
@@ -11,6 +11,7 @@
 */
 
 #include <algorithm>
+#include <functional>
 
 #include <pistache/description.h>
 #include <pistache/router.h>
@@ -25,8 +26,73 @@ namespace Pistache::Rest
         , splats_(std::move(splats))
     { }
 
+    Request::Request(Http::Request request, const RouteMatch& match,
+                     std::string_view matchedResource)
+        : Http::Request(std::move(request))
+    {
+        if (match.size() > InlineEntries)
+        {
+            params_ = match.params();
+            splats_ = match.splats();
+            return;
+        }
+
+        for (const auto& matched : match)
+        {
+            auto& entry     = entries_[entriesSize_++];
+            entry.value     = static_cast<uint32_t>(matched.value.data() - matchedResource.data());
+            entry.valueSize = static_cast<uint32_t>(matched.value.size());
+
+            if (matched.splat)
+            {
+                entry.name     = Entry::Splat;
+                entry.nameSize = 0;
+                continue;
+            }
+
+            entry.name     = static_cast<uint32_t>(names_.size());
+            entry.nameSize = static_cast<uint32_t>(matched.name.size());
+            names_.append(matched.name);
+        }
+    }
+
+    Request& Request::operator=(const Request& other)
+    {
+        if (this != &other)
+        {
+            // TypedParam can not be assigned, the vectors are replaced
+            Http::Request::operator=(other);
+            params_      = std::vector<TypedParam>(other.params_);
+            splats_      = std::vector<TypedParam>(other.splats_);
+            entries_     = other.entries_;
+            entriesSize_ = other.entriesSize_;
+            names_       = other.names_;
+        }
+        return *this;
+    }
+
+    std::string_view Request::nameOf(const Entry& entry) const
+    {
+        if (entry.name == Entry::Splat)
+            return valueOf(entry);
+
+        return std::string_view(names_).substr(entry.name, entry.nameSize);
+    }
+
+    std::string_view Request::valueOf(const Entry& entry) const
+    {
+        return std::string_view(resource()).substr(entry.value, entry.valueSize);
+    }
+
     bool Request::hasParam(const std::string& name) const
     {
+        for (size_t i = 0; i < entriesSize_; ++i)
+        {
+            const auto& entry = entries_[i];
+            if (entry.name != Entry::Splat && nameOf(entry) == name)
+                return true;
+        }
+
         auto it = std::find_if(
             params_.begin(), params_.end(),
             [&](const TypedParam& param) { return param.name() == name; });
@@ -36,6 +102,13 @@ namespace Pistache::Rest
 
     TypedParam Request::param(const std::string& name) const
     {
+        for (size_t i = 0; i < entriesSize_; ++i)
+        {
+            const auto& entry = entries_[i];
+            if (entry.name != Entry::Splat && nameOf(entry) == name)
+                return TypedParam(std::string(nameOf(entry)), std::string(valueOf(entry)));
+        }
+
         auto it = std::find_if(
             params_.begin(), params_.end(),
             [&](const TypedParam& param) { return param.name() == name; });
@@ -50,6 +123,13 @@ namespace Pistache::Rest
 
     TypedParam Request::splatAt(size_t index) const
     {
+        for (size_t i = 0; i < entriesSize_; ++i)
+        {
+            const auto& entry = entries_[i];
+            if (entry.name == Entry::Splat && index-- == 0)
+                return TypedParam(std::string(nameOf(entry)), std::string(valueOf(entry)));
+        }
+
         if (index >= splats_.size())
         {
             throw std::out_of_range("Request splat index out of range");
@@ -57,7 +137,45 @@ namespace Pistache::Rest
         return splats_[index];
     }
 
-    std::vector<TypedParam> Request::splat() const { return splats_; }
+    std::vector<TypedParam> Request::splat() const
+    {
+        // Only one of them is ever set
+        if (!splats_.empty())
+            return splats_;
+
+        std::vector<TypedParam> result;
+        for (size_t i = 0; i < entriesSize_; ++i)
+        {
+            const auto& entry = entries_[i];
+            if (entry.name == Entry::Splat)
+                result.emplace_back(std::string(nameOf(entry)), std::string(valueOf(entry)));
+        }
+        return result;
+    }
+
+    std::vector<TypedParam> RouteMatch::params() const
+    {
+        std::vector<TypedParam> result;
+        result.reserve(size_);
+        for (const auto& entry : *this)
+        {
+            if (!entry.splat)
+                result.emplace_back(std::string(entry.name), std::string(entry.value));
+        }
+        return result;
+    }
+
+    std::vector<TypedParam> RouteMatch::splats() const
+    {
+        std::vector<TypedParam> result;
+        result.reserve(size_);
+        for (const auto& entry : *this)
+        {
+            if (entry.splat)
+                result.emplace_back(std::string(entry.name), std::string(entry.value));
+        }
+        return result;
+    }
 
     std::regex SegmentTreeNode::multiple_slash = std::regex("//+", std::regex_constants::optimize);
 
@@ -355,6 +473,78 @@ namespace Pistache::Rest
         return findRoute(path, params, splats);
     }
 
+    const Route* SegmentTreeNode::matchRoute(std::string_view path,
+                                             RouteMatch& match) const
+    {
+        // Skipping empty segments is equivalent to collapsing multiple
+        // slashes and stripping leading and trailing ones
+        const auto first = path.find_first_not_of('/');
+        path.remove_prefix(first == std::string_view::npos ? path.size() : first);
+
+        if (path.empty())
+        { // current leaf requested, or empty final optional
+            if (!optional_.empty())
+                return optional_.begin()->second->matchRoute(path, match);
+            return route_.get();
+        }
+
+        const auto segment_delimiter = path.find('/');
+        const auto current_segment   = path.substr(0, segment_delimiter);
+        const auto lower_path        = (segment_delimiter == std::string_view::npos)
+                   ? std::string_view {}
+                   : path.substr(segment_delimiter + 1);
+
+        const auto fixed = fixed_.find(current_segment);
+        if (fixed != fixed_.end())
+        {
+            if (const auto* route = fixed->second->matchRoute(lower_path, match))
+                return route;
+            if (match.overflowed())
+                return nullptr;
+        }
+
+        for (const auto& param : param_)
+        {
+            if (!match.push(param.first, current_segment, false))
+                return nullptr;
+            if (const auto* route = param.second->matchRoute(lower_path, match))
+                return route;
+            if (match.overflowed())
+                return nullptr;
+            match.pop();
+        }
+
+        for (const auto& optional : optional_)
+        {
+            if (!match.push(optional.first, current_segment, false))
+                return nullptr;
+            if (const auto* route = optional.second->matchRoute(lower_path, match))
+                return route;
+            if (match.overflowed())
+                return nullptr;
+            match.pop();
+            // try to find a route for lower path assuming that
+            // this optional path param is not present
+            if (const auto* route = optional.second->matchRoute(lower_path, match))
+                return route;
+            if (match.overflowed())
+                return nullptr;
+        }
+
+        if (splat_ != nullptr)
+        {
+            if (!match.push(current_segment, current_segment, true))
+                return nullptr;
+            if (const auto* route = splat_->matchRoute(lower_path, match))
+                return route;
+            if (match.overflowed())
+                return nullptr;
+            match.pop();
+        }
+
+        return nullptr;
+    }
+
     namespace Private
     {
 
@@ -519,25 +709,40 @@ namespace Pistache::Rest
                 return Route::Status::Match;
         }
 
-        std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>,
-                   std::vector<TypedParam>>
-            result;
-
-        const auto sanitized = SegmentTreeNode::sanitizeResource(resource);
-        const std::string_view path { sanitized.data(), sanitized.size() };
+        // sanitizeResource() unconditionally drops the first character of
+        // the resource (the leading slash, or the '*' of an asterisk-form
+        // request-target), so do the same before matching
+        const std::string_view path = std::string_view(resource).substr(1);
 
         const auto routesIt = routes.find(req.method());
         if (routesIt != routes.end())
-            result = routesIt->second.findRoute(path);
-
-        auto route = std::get<0>(result);
-        if (route != nullptr)
         {
-            auto params = std::get<1>(result);
-            auto splats = std::get<2>(result);
-            route->invokeHandler(Request(std::move(req), std::move(params), std::move(splats)),
-                                 std::move(resp));
-            return Route::Status::Match;
+            RouteMatch match;
+            const auto* route = routesIt->second.matchRoute(path, match);
+            if (route != nullptr)
+            {
+                // match holds views into resource, which req has a copy of
+                route->invokeHandler(Request(std::move(req), match, resource),
+                                     std::move(resp));
+                return Route::Status::Match;
+            }
+
+            if (match.overflowed())
+            {
+                // Too many parameters for the inline buffer, fall back on
+                // the allocating lookup
+                const auto sanitized = SegmentTreeNode::sanitizeResource(resource);
+                auto result          = routesIt->second.findRoute(
+                    std::string_view { sanitized.data(), sanitized.size() });
+                if (std::get<0>(result) != nullptr)
+                {
+                    std::get<0>(result)->invokeHandler(
+                        Request(std::move(req), std::move(std::get<1>(result)),
+                                std::move(std::get<2>(result))),
+                        std::move(resp));
+                    return Route::Status::Match;
+                }
+            }
         }
 
         for (const auto& handler : customHandlers)
@@ -563,9 +768,17 @@ namespace Pistache::Rest
             if (methods.first == req.method())
                 continue;
 
-            auto res = methods.second.findRoute(path);
-            auto rte = std::get<0>(res);
-            if (rte != nullptr)
+            RouteMatch match;
+            bool found = methods.second.matchRoute(path, match) != nullptr;
+            if (!found && match.overflowed())
+            {
+                const auto sanitized = SegmentTreeNode::sanitizeResource(resource);
+                found                = std::get<0>(methods.second.findRoute(
+                                           std::string_view { sanitized.data(), sanitized.size() }))
+                    != nullptr;
+            }
+
+            if (found)
             {
                 supportedMethods.push_back(methods.first);
             }
@@ -519,3 +519,54 @@ TEST(async_test, chain_rejects)
     (*rejecter)(std::runtime_error("foo"));
     ASSERT_TRUE(ok);
 }
+
+TEST(async_test, every_continuation_runs_once)
+{
+    // Attached before and after the promise is resolved
+    Async::Deferred<int> deferred;
+    Async::Promise<int> promise(
+        [&](Async::Deferred<int> d) { deferred = std::move(d); });
+
+    int sum = 0;
+    for (int i = 0; i < 3; ++i)
+        promise.then([&](int v) { sum += v; }, Async::NoExcept);
+
+    deferred.resolve(1);
+    ASSERT_EQ(sum, 3);
+
+    for (int i = 0; i < 3; ++i)
+        promise.then([&](int v) { sum += v; }, Async::NoExcept);
+    ASSERT_EQ(sum, 6);
+
+    auto rejected = Async::Promise<int>::rejected(std::runtime_error("nope"));
+    int rejections = 0;
+    for (int i = 0; i < 2; ++i)
+        rejected.then([](int) {}, [&](std::exception_ptr) { ++rejections; });
+    ASSERT_EQ(rejections, 2);
+}
+
+TEST(async_test, resolve_races_with_then)
+{
+    static constexpr int Rounds        = 20000;
+    static constexpr int Continuations = 4;
+
+    std::atomic<int> runs(0);
+    for (int i = 0; i < Rounds; ++i)
+    {
+        Async::Deferred<int> deferred;
+        Async::Promise<int> promise(
+            [&](Async::Deferred<int> d) { deferred = std::move(d); });
+
+        std::thread resolver([&deferred] { deferred.resolve(1); });
+
+        // The first continuation is kept inline, the others go to the
+        // locked list, so that both paths race with the resolver
+        for (int j = 0; j < Continuations; ++j)
+            promise.then([&](int) { ++runs; }, Async::NoExcept);
+
+        resolver.join();
+    }
+
+    ASSERT_EQ(runs.load(), Continuations * Rounds);
+}
+
@@ -0,0 +1,535 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Micro-benchmarks, only built when asked for with
+ * PISTACHE_BUILD_BENCHMARKS (meson: PISTACHE_BUILD_BENCHMARKS, run with
+ * "meson test --benchmark").
+ *
+ * Each benchmark prints how long one operation took on average and how many
+ * heap allocations it made, so that a change can be measured by running
+ * this file before and after it. The assertions only check that the work
+ * was actually done.
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/async.h>
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+
+#include "tcp_client.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace Pistache;
+
+namespace
+{
+    std::atomic<size_t> allocations(0);
+}
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+    // Runs op iterations times, after a few warm-up runs, and reports the
+    // average time and allocations of one of the opsPerRun operations that
+    // a run does
+    template <typename Op>
+    void measure(const std::string& name, size_t iterations, Op&& op, size_t opsPerRun = 1)
+    {
+        for (size_t i = 0; i < iterations / 100 + 1; ++i)
+            op();
+
+        const size_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+        const auto start               = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; ++i)
+            op();
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const size_t made  = allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+        const auto ns    = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        const double ops = static_cast<double>(iterations * opsPerRun);
+        std::printf("[ BENCH    ] %-40s %10.1f ns/op %8.2f allocs/op\n", name.c_str(),
+                    static_cast<double>(ns) / ops, static_cast<double>(made) / ops);
+    }
+
+    struct OkHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(OkHandler)
+
+        void onRequest(const Http::Request& /*request*/, Http::ResponseWriter writer) override
+        {
+            writer.send(Http::Code::Ok, "ok");
+        }
+    };
+
+    // Answers with a 1 KiB body, a few typed headers and a cookie
+    struct HeadersHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(HeadersHandler)
+
+        void onRequest(const Http::Request& /*request*/, Http::ResponseWriter writer) override
+        {
+            static const std::string Body(1024, 'x');
+
+            writer.headers()
+                .add<Http::Header::Server>("pistache")
+                .add<Http::Header::ContentType>(MIME(Text, Plain));
+            writer.cookies().add(Http::Cookie("session", "0123456789"));
+            writer.send(Http::Code::Ok, Body);
+        }
+    };
+
+    // Streams a response as chunks that are flushed one at a time, so that
+    // their writes queue up for the peer
+    struct StreamingHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(StreamingHandler)
+
+        static constexpr size_t Chunks = 256;
+
+        void onRequest(const Http::Request& /*request*/, Http::ResponseWriter writer) override
+        {
+            static const std::string Chunk(64, 'x');
+
+            auto stream = writer.stream(Http::Code::Ok);
+            for (size_t i = 0; i < Chunks; ++i)
+            {
+                stream << Chunk.c_str();
+                stream.flush();
+            }
+            stream.ends();
+        }
+    };
+
+    // Answers with a body too big to fit in the socket buffers at once
+    struct LargeBodyHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(LargeBodyHandler)
+
+        static constexpr size_t BodySize = 1024 * 1024;
+
+        void onRequest(const Http::Request& /*request*/, Http::ResponseWriter writer) override
+        {
+            static const std::string Body(BodySize, 'x');
+            writer.send(Http::Code::Ok, Body);
+        }
+    };
+
+    // Feeds request to parser in pieces of the given sizes, parsing after
+    // each of them, and returns whether the request was complete by the end
+    bool parseInPieces(Http::RequestParser& parser, const std::string& request,
+                       const std::vector<size_t>& pieces)
+    {
+        auto state    = Http::Private::State::Again;
+        size_t offset = 0;
+        for (size_t piece : pieces)
+        {
+            if (!parser.feed(request.data() + offset, piece))
+                return false;
+            offset += piece;
+            state = parser.parse();
+        }
+
+        parser.reset();
+        return state == Http::Private::State::Done;
+    }
+
+    // Reads from client until count more responses have arrived, and
+    // returns false if they did not
+    bool receiveResponses(TcpClient& client, size_t count)
+    {
+        static const std::string StatusLine = "HTTP/1.1 200 OK";
+
+        std::string received;
+        size_t pos = 0;
+        char buffer[16384];
+        while (count > 0)
+        {
+            size_t bytes = 0;
+            if (!client.receive(buffer, sizeof(buffer), &bytes, std::chrono::seconds(5)) || bytes == 0)
+                return false;
+            received.append(buffer, bytes);
+
+            size_t found;
+            while (count > 0 && (found = received.find(StatusLine, pos)) != std::string::npos)
+            {
+                pos = found + StatusLine.size();
+                --count;
+            }
+        }
+        return true;
+    }
+
+    // Reads from client until a chunked response has been received whole,
+    // and returns false if it was not
+    bool receiveChunkedResponse(TcpClient& client)
+    {
+        static const std::string LastChunk = "\r\n0\r\n\r\n";
+
+        std::string received;
+        char buffer[16384];
+        while (received.size() < LastChunk.size()
+               || received.compare(received.size() - LastChunk.size(), LastChunk.size(), LastChunk) != 0)
+        {
+            size_t bytes = 0;
+            if (!client.receive(buffer, sizeof(buffer), &bytes, std::chrono::seconds(5)) || bytes == 0)
+                return false;
+            received.append(buffer, bytes);
+        }
+        return true;
+    }
+
+    // Reads a response with a body of bodySize bytes from each of clients,
+    // 4 KiB at a time and taking turns, as readers slower than the server
+    // would. Returns false if one of them did not get its response.
+    bool receiveSlowly(std::vector<TcpClient>& clients, size_t bodySize)
+    {
+        static const std::string EndOfHead = "\r\n\r\n";
+
+        struct Progress
+        {
+            std::string head;
+            bool inBody     = false;
+            size_t bodyRead = 0;
+        };
+        std::vector<Progress> progress(clients.size());
+
+        size_t done = 0;
+        char buffer[4096];
+        while (done < clients.size())
+        {
+            for (size_t i = 0; i < clients.size(); ++i)
+            {
+                auto& p = progress[i];
+                if (p.inBody && p.bodyRead >= bodySize)
+                    continue;
+
+                size_t bytes = 0;
+                if (!clients[i].receive(buffer, sizeof(buffer), &bytes, std::chrono::seconds(5)) || bytes == 0)
+                    return false;
+
+                if (p.inBody)
+                {
+                    p.bodyRead += bytes;
+                }
+                else
+                {
+                    p.head.append(buffer, bytes);
+                    const auto end = p.head.find(EndOfHead);
+                    if (end == std::string::npos)
+                        continue;
+
+                    p.inBody   = true;
+                    p.bodyRead = p.head.size() - end - EndOfHead.size();
+                }
+
+                if (p.bodyRead >= bodySize)
+                    ++done;
+            }
+        }
+        return true;
+    }
+}
+
+TEST(benchmark, promise_chains)
+{
+    static constexpr size_t Iterations = 200000;
+    long sum                           = 0;
+
+    measure("promise: resolved, then", Iterations, [&] {
+        Async::Promise<int>::resolved(1).then([&](int v) { sum += v; }, Async::NoExcept);
+    });
+
+    measure("promise: then, then, resolve", Iterations, [&] {
+        Async::Deferred<int> deferred;
+        Async::Promise<int> promise(
+            [&](Async::Deferred<int> d) { deferred = std::move(d); });
+        promise.then([](int v) { return v + 1; }, Async::Throw)
+            .then([&](int v) { sum += v; }, Async::NoExcept);
+        deferred.resolve(1);
+    });
+
+    measure("promise: three continuations, resolve", Iterations, [&] {
+        Async::Deferred<int> deferred;
+        Async::Promise<int> promise(
+            [&](Async::Deferred<int> d) { deferred = std::move(d); });
+        for (int i = 0; i < 3; ++i)
+            promise.then([&](int v) { sum += v; }, Async::NoExcept);
+        deferred.resolve(1);
+    });
+
+    measure("promise: rejected, then", Iterations, [&] {
+        Async::Promise<int>::rejected(std::runtime_error("nope"))
+            .then([](int) {}, [&](std::exception_ptr) { ++sum; });
+    });
+
+    // Warm-up runs included
+    const long runs = static_cast<long>(Iterations + Iterations / 100 + 1);
+    ASSERT_EQ(sum, runs * (1 + 2 + 3 + 1));
+}
+
+TEST(benchmark, request_parsing)
+{
+    static constexpr size_t Iterations = 20000;
+
+    const std::string body = R"({"name":"pistache","count":42})";
+    const std::string request
+        = "POST /api/v1/items?id=42&sort=asc HTTP/1.1\r\n"
+          "Host: localhost:9080\r\n"
+          "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+          "Accept: application/json\r\n"
+          "Accept-Encoding: gzip, deflate\r\n"
+          "Content-Type: application/json\r\n"
+          "Content-Length: "
+        + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+    // A request read in one go, one byte per read, and over reads of
+    // random sizes, as it would arrive from a slow or bursty client
+    const std::vector<size_t> whole = { request.size() };
+    const std::vector<size_t> bytes(request.size(), 1);
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<size_t> pieceSize(1, 64);
+    std::vector<size_t> chunks;
+    for (size_t left = request.size(); left > 0;)
+    {
+        chunks.push_back(std::min(pieceSize(rng), left));
+        left -= chunks.back();
+    }
+
+    Http::RequestParser parser(Const::DefaultMaxRequestSize);
+
+    size_t parsed = 0;
+    measure("parser: whole request", Iterations,
+            [&] { parsed += parseInPieces(parser, request, whole); });
+    measure("parser: byte by byte", Iterations,
+            [&] { parsed += parseInPieces(parser, request, bytes); });
+    measure("parser: random chunks", Iterations,
+            [&] { parsed += parseInPieces(parser, request, chunks); });
+
+    // Warm-up runs included
+    ASSERT_EQ(parsed, 3 * (Iterations + Iterations / 100 + 1));
+}
+
+TEST(benchmark, header_parsing)
+{
+    static constexpr size_t Iterations = 20000;
+
+    // Long lines with their delimiters far apart, as the scans for them
+    // are what this measures
+    std::string headers = "GET / HTTP/1.1\r\nHost: localhost:9080\r\n";
+    for (size_t i = 0; i < 32; ++i)
+        headers += "X-Custom-Header-" + std::to_string(i) + ": " + std::string(48, 'v') + "\r\n";
+    headers += "\r\n";
+
+    std::string query = "GET /search?";
+    for (size_t i = 0; i < 64; ++i)
+        query += (i > 0 ? "&" : "") + std::string("key") + std::to_string(i) + "=" + std::string(24, 'v');
+    query += " HTTP/1.1\r\nHost: localhost:9080\r\n\r\n";
+
+    Http::RequestParser parser(Const::DefaultMaxRequestSize);
+
+    size_t parsed = 0;
+    measure("parser: 32 headers", Iterations,
+            [&] { parsed += parseInPieces(parser, headers, { headers.size() }); });
+    measure("parser: 2 KiB query string", Iterations,
+            [&] { parsed += parseInPieces(parser, query, { query.size() }); });
+
+    // The scan on its own, against the scalar search the parser used
+    // before, over the query string where the delimiters are farthest
+    const std::string_view line(query);
+    size_t scanned = 0;
+    measure("scan: find_any_of, 2 KiB", Iterations, [&] {
+        scanned += static_cast<size_t>(
+            find_any_of(line.data(), line.data() + line.size(), "\r\n") - line.data());
+    });
+    measure("scan: string_view::find_first_of, 2 KiB", Iterations,
+            [&] { scanned += line.find_first_of("\r\n"); });
+
+    // Warm-up runs included
+    const size_t runs = Iterations + Iterations / 100 + 1;
+    ASSERT_EQ(parsed, 2 * runs);
+    ASSERT_EQ(scanned, 2 * runs * line.find('\r'));
+}
+
+TEST(benchmark, pipelining_depth)
+{
+    // Requests answered per depth, so that every depth does the same work
+    static constexpr size_t Requests = 4096;
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<OkHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Address("localhost", server.getPort()))) << client.lastError();
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    bool answered = true;
+    for (size_t depth : { 1, 4, 16, 64, 256 })
+    {
+        std::string batch;
+        for (size_t i = 0; i < depth; ++i)
+            batch += request;
+
+        measure(
+            "pipelining: depth " + std::to_string(depth), Requests / depth, [&] {
+                answered = answered && client.send(batch) && receiveResponses(client, depth);
+            },
+            depth);
+    }
+
+    server.shutdown();
+
+    ASSERT_TRUE(answered);
+}
+
+TEST(benchmark, response_writes)
+{
+    static constexpr size_t Requests = 4096;
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<HeadersHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Address("localhost", server.getPort()))) << client.lastError();
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    // Client side included, which is the same for every build
+    bool answered = true;
+    measure("response: 1 KiB, headers and a cookie", Requests, [&] {
+        answered = answered && client.send(request) && receiveResponses(client, 1);
+    });
+
+    server.shutdown();
+
+    ASSERT_TRUE(answered);
+}
+
+TEST(benchmark, streaming_writes)
+{
+    static constexpr size_t Responses = 256;
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<StreamingHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Address("localhost", server.getPort()))) << client.lastError();
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    // Per chunk, client side included
+    bool answered = true;
+    measure(
+        "streaming: 64 B flushed chunks", Responses, [&] {
+            answered = answered && client.send(request) && receiveChunkedResponse(client);
+        },
+        StreamingHandler::Chunks);
+
+    server.shutdown();
+
+    ASSERT_TRUE(answered);
+}
+
+TEST(benchmark, slow_readers)
+{
+    static constexpr size_t Connections = 8;
+    static constexpr size_t Rounds      = 8;
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<LargeBodyHandler>());
+    server.serveThreaded();
+
+    std::vector<TcpClient> clients(Connections);
+    for (auto& client : clients)
+        ASSERT_TRUE(client.connect(Address("localhost", server.getPort()))) << client.lastError();
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    // Every response fills the socket buffers many times over, so that the
+    // server keeps waiting for the readers to make room, while their
+    // requests and reads make it wake up for all of them
+    bool answered = true;
+    measure(
+        "slow readers: 8 connections, 1 MiB", Rounds, [&] {
+            for (auto& client : clients)
+                answered = answered && client.send(request);
+            answered = answered && receiveSlowly(clients, LargeBodyHandler::BodySize);
+        },
+        Connections);
+
+    server.shutdown();
+
+    ASSERT_TRUE(answered);
+}
+
+TEST(benchmark, keep_alive_connections)
+{
+    static constexpr size_t Connections = 16;
+    static constexpr size_t Rounds      = 256;
+
+    Http::Endpoint server(Address("localhost", Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<OkHandler>());
+    server.serveThreaded();
+
+    std::vector<TcpClient> clients(Connections);
+    for (auto& client : clients)
+        ASSERT_TRUE(client.connect(Address("localhost", server.getPort()))) << client.lastError();
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    // One request in flight per connection
+    bool answered = true;
+    measure(
+        "keep-alive: 16 connections", Rounds, [&] {
+            for (auto& client : clients)
+                answered = answered && client.send(request);
+            for (auto& client : clients)
+                answered = answered && receiveResponses(client, 1);
+        },
+        Connections);
+
+    server.shutdown();
+
+    ASSERT_TRUE(answered);
+}
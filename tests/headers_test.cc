@@ -1017,6 +1017,96 @@ TEST(headers_test, cookie_headers_are_case_insensitive)
     }
 }
 
+TEST(headers_test, known_headers_index)
+{
+    namespace Known = Pistache::Http::Header::Known;
+
+    static_assert(Known::IndexOf<Pistache::Http::Header::Host> != Known::None);
+    static_assert(Known::IndexOf<TestHeader> == Known::None);
+
+    for (size_t i = 0; i < Known::Count; ++i)
+    {
+        ASSERT_EQ(Known::index(Known::Names[i]), i);
+        ASSERT_EQ(Known::index(toLowercase(Known::Names[i])), i);
+    }
+
+    ASSERT_EQ(Known::index("CONTENT-LENGTH"), Known::IndexOf<ContentLength>);
+    ASSERT_EQ(Known::index("Content-Lengt"), Known::None);
+    ASSERT_EQ(Known::index("Content-Length2"), Known::None);
+    ASSERT_EQ(Known::index(""), Known::None);
+    ASSERT_EQ(Known::index("X-Custom"), Known::None);
+}
+
+TEST(headers_test, known_and_custom_headers_in_collection)
+{
+    Pistache::Http::Header::Collection headers;
+    headers.add<Host>("localhost");
+    headers.add<Host>("example.com");
+    headers.add<TestHeader>("custom");
+
+    // As for custom headers, the first known header added wins
+    ASSERT_EQ(headers.get<Host>()->host(), "localhost");
+    ASSERT_EQ(headers.get("HOST")->name(), std::string("Host"));
+    ASSERT_EQ(headers.get<TestHeader>()->val(), "custom");
+    ASSERT_TRUE(headers.has("test-header"));
+    ASSERT_EQ(headers.list().size(), 2u);
+
+    ASSERT_FALSE(headers.has<ContentLength>());
+    ASSERT_EQ(headers.tryGet<ContentLength>(), nullptr);
+    ASSERT_THROW(headers.get<ContentLength>(), std::runtime_error);
+
+    ASSERT_TRUE(headers.remove<Host>());
+    ASSERT_FALSE(headers.has<Host>());
+    ASSERT_FALSE(headers.remove<Host>());
+    ASSERT_EQ(headers.list().size(), 1u);
+}
+
+TEST(headers_test, lazy_headers)
+{
+    Pistache::Http::Header::Collection headers;
+    headers.addLazy("host", "localhost:8080");
+    headers.addLazy("X-Custom", "first");
+    headers.addLazy("x-custom", "second");
+    headers.addLazy("Content-Length", "42");
+
+    ASSERT_TRUE(headers.has<Pistache::Http::Header::Host>());
+    ASSERT_EQ(headers.get<Pistache::Http::Header::Host>()->host(), "localhost");
+    ASSERT_EQ(headers.getRaw("HOST").value(), "localhost:8080");
+
+    // The first occurrence of a header wins, as with eagerly parsed headers
+    ASSERT_EQ(headers.getRaw("X-CUSTOM").value(), "first");
+    ASSERT_FALSE(headers.has("X-Custom"));
+    ASSERT_FALSE(headers.tryGetRaw("Accept").has_value());
+
+    ASSERT_EQ(headers.rawList().size(), 3u);
+    ASSERT_EQ(headers.tryGet<Pistache::Http::Header::ContentLength>()->value(), 42u);
+
+    headers.clear();
+    ASSERT_TRUE(headers.rawList().empty());
+}
+
+TEST(headers_test, lazy_headers_step)
+{
+    std::string test = "Host: localhost\r\n"
+                       "Cookie: x=y\r\n"
+                       "Custom-Header: x\r\n"
+                       "\r\n";
+
+    Pistache::RawStreamBuf<> buf(&test[0], test.size());
+    Pistache::StreamCursor cursor(&buf);
+    Pistache::Http::Request request;
+    Pistache::Http::Private::HeadersStep step(&request);
+    step.setLazy(true);
+    ASSERT_EQ(step.apply(cursor), Pistache::Http::Private::State::Next);
+
+    // Cookies are still parsed right away
+    ASSERT_TRUE(request.cookies().has("x"));
+
+    ASSERT_EQ(request.headers().get<Pistache::Http::Header::Host>()->host(), "localhost");
+    ASSERT_TRUE(request.headers().tryGetRaw("custom-header").has_value());
+    ASSERT_EQ(request.headers().rawList().size(), 3u);
+}
+
 TEST(headers_test, etag_test)
 {
     {
@@ -8,6 +8,8 @@
 #include <pistache/http.h>
 #include <pistache/stream.h>
 
+#include <algorithm>
+#include <random>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -76,6 +78,60 @@ TEST(http_parsing_test, parser_reset)
     ASSERT_EQ(parser.request.body(), "");
 }
 
+TEST(http_parsing_test, parser_next_message_keeps_pipelined_requests)
+{
+    Http::RequestParser parser(Const::DefaultMaxRequestSize);
+
+    auto feed = [&parser](const char* data) {
+        parser.feed(data, std::strlen(data));
+    };
+
+    // Two complete requests and the start of a third one in a single read
+    feed("POST /first HTTP/1.1\r\nContent-Length: 5\r\n\r\nHELLO"
+         "GET /second HTTP/1.1\r\nHost: localhost\r\n\r\n"
+         "GET /thi");
+
+    ASSERT_EQ(parser.parse(), Http::Private::State::Done);
+    ASSERT_EQ(parser.request.resource(), "/first");
+    ASSERT_EQ(parser.request.body(), "HELLO");
+
+    parser.nextMessage();
+    ASSERT_EQ(parser.request.resource(), "");
+
+    ASSERT_EQ(parser.parse(), Http::Private::State::Done);
+    ASSERT_EQ(parser.request.resource(), "/second");
+    ASSERT_EQ(parser.request.headers().list().size(), 1u);
+    ASSERT_EQ(parser.request.body(), "");
+
+    parser.nextMessage();
+    ASSERT_EQ(parser.parse(), Http::Private::State::Again);
+
+    // Dropping the requests parsed so far keeps the partial one
+    ASSERT_TRUE(parser.compact());
+    ASSERT_FALSE(parser.compact());
+
+    feed("rd HTTP/1.1\r\n\r\n");
+    ASSERT_EQ(parser.parse(), Http::Private::State::Done);
+    ASSERT_EQ(parser.request.resource(), "/third");
+
+    // Nothing is left once the last request has been parsed
+    parser.nextMessage();
+    ASSERT_EQ(parser.parse(), Http::Private::State::Again);
+}
+
+TEST(http_parsing_test, parser_feed_some_stops_at_max_size)
+{
+    Http::RequestParser parser(16);
+
+    const std::string data = "GET /x HTTP/1.1\r\n\r\nGET /y HTTP/1.1\r\n\r\n";
+    size_t fed = parser.feedSome(data.data(), data.size());
+    ASSERT_EQ(fed, 16u);
+
+    // The first request does not fit either, and is never Done
+    ASSERT_EQ(parser.parse(), Http::Private::State::Again);
+    ASSERT_EQ(parser.feedSome(data.data() + fed, data.size() - fed), 0u);
+}
+
 TEST(http_parsing_test, succ_response_line_step)
 {
     Http::Response response;
@@ -215,3 +271,93 @@ TEST(http_parsing_test, succ_method_parse_request)
         }
     }
 }
+
+namespace
+{
+    const std::string fullRequest = "POST /hello?key=value&flag HTTP/1.1\r\n"
+                                    "Host: localhost\r\n"
+                                    "User-Agent: Mozilla/5.0 (Windows NT 6.1) AppleWebKit/537.36\r\n"
+                                    "Cookie: session=abcd\r\n"
+                                    "Transfer-Encoding: chunked\r\n"
+                                    "\r\n"
+                                    "5\r\nHELLO\r\n"
+                                    "6\r\n WORLD\r\n"
+                                    "0\r\n\r\n";
+
+    void checkFullRequest(const Http::RequestParser& parser)
+    {
+        const auto& request = parser.request;
+        ASSERT_EQ(request.method(), Http::Method::Post);
+        ASSERT_EQ(request.resource(), "/hello");
+        ASSERT_EQ(request.query().get("key"), "value");
+        ASSERT_TRUE(request.query().has("flag"));
+        ASSERT_EQ(request.version(), Http::Version::Http11);
+        ASSERT_EQ(request.headers().rawList().size(), 4u);
+        ASSERT_EQ(request.headers().get<Http::Header::Host>()->host(), "localhost");
+        ASSERT_TRUE(request.cookies().has("session"));
+        ASSERT_EQ(request.body(), "HELLO WORLD");
+    }
+} // namespace
+
+TEST(http_parsing_test, parse_request_byte_by_byte)
+{
+    Http::RequestParser parser(Const::DefaultMaxRequestSize);
+
+    for (size_t i = 0; i < fullRequest.size(); ++i)
+    {
+        ASSERT_TRUE(parser.feed(&fullRequest[i], 1));
+        const auto state = parser.parse();
+        if (i + 1 < fullRequest.size())
+            ASSERT_EQ(state, Http::Private::State::Again);
+        else
+            ASSERT_EQ(state, Http::Private::State::Done);
+    }
+
+    checkFullRequest(parser);
+}
+
+TEST(http_parsing_test, parse_request_in_random_chunks)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> chunkSize(1, 16);
+
+    for (int round = 0; round < 32; ++round)
+    {
+        Http::RequestParser parser(Const::DefaultMaxRequestSize);
+
+        auto state = Http::Private::State::Again;
+        for (size_t i = 0; i < fullRequest.size();)
+        {
+            const auto len = std::min(chunkSize(rng), fullRequest.size() - i);
+            ASSERT_TRUE(parser.feed(&fullRequest[i], len));
+            state = parser.parse();
+            i += len;
+        }
+
+        ASSERT_EQ(state, Http::Private::State::Done);
+        checkFullRequest(parser);
+    }
+}
+
+TEST(http_parsing_test, parse_request_lazy_headers)
+{
+    Http::RequestParser parser(Const::DefaultMaxRequestSize);
+    parser.setLazyHeaders(true);
+
+    for (size_t i = 0; i < fullRequest.size(); ++i)
+    {
+        ASSERT_TRUE(parser.feed(&fullRequest[i], 1));
+        parser.parse();
+    }
+
+    checkFullRequest(parser);
+}
+
+TEST(http_parsing_test, error_header_without_colon)
+{
+    Http::RequestParser parser(Const::DefaultMaxRequestSize);
+
+    const std::string data = "GET / HTTP/1.1\r\nHost localhost\r\n\r\n";
+    ASSERT_TRUE(parser.feed(data.data(), data.size()));
+    ASSERT_THROW(parser.parse(), Http::HttpError);
+}
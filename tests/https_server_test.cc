@@ -6,12 +6,14 @@
 
 #include <array>
 #include <cstring>
+#include <sstream>
 
 #include <pistache/winornix.h>
 #include <pistache/ps_strl.h> // for PS_STRNCPY_S
 #include <pistache/client.h>
 #include <pistache/endpoint.h>
 #include <pistache/http.h>
+#include <pistache/string_logger.h>
 
 #include <gtest/gtest.h>
 
@@ -300,9 +302,12 @@ TEST(https_server_test, basic_tls_request_with_auth)
 
 TEST(https_server_test, basic_tls_request_with_auth_no_client_cert)
 {
+    std::stringstream log;
+    auto logger = std::make_shared<Log::StringToStreamLogger>(Log::Level::LL_INFO, &log);
+
     Http::Endpoint server(Address("localhost", Pistache::Port(0)));
     auto flags       = Tcp::Options::ReuseAddr;
-    auto server_opts = Http::Endpoint::options().flags(flags);
+    auto server_opts = Http::Endpoint::options().flags(flags).logger(logger);
 
     server.init(server_opts);
     server.setHandler(Http::make_handler<HelloHandler>());
@@ -336,6 +341,9 @@ TEST(https_server_test, basic_tls_request_with_auth_no_client_cert)
     server.shutdown();
 
     ASSERT_NE(res, CURLE_OK);
+
+    // The failed handshake is reported to the logger of the endpoint
+    EXPECT_NE(log.str().find("SSL connection error"), std::string::npos) << log.str();
 }
 
 TEST(https_server_test, basic_tls_request_with_auth_client_cert_not_signed)
@@ -576,6 +584,47 @@ TEST(https_server_test, basic_tls_requests_with_no_shutdown_from_peer)
     server.shutdown();
 }
 
+TEST(https_server_test, tls_connection_close_sends_close_notify)
+{
+    Http::Endpoint server(Address("localhost", Pistache::Port(0)));
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<HelloHandler>());
+    server.useSSL("./certs/server.crt", "./certs/server.key");
+    server.serveThreaded();
+
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    ASSERT_NE(ctx, nullptr);
+
+    BIO* bio = BIO_new_ssl_connect(ctx);
+    ASSERT_NE(bio, nullptr);
+    const std::string hostPort = "localhost:" + server.getPort().toString();
+    BIO_set_conn_hostname(bio, hostPort.c_str());
+    ASSERT_EQ(BIO_do_connect(bio), 1);
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    ASSERT_EQ(BIO_write(bio, request.data(), static_cast<int>(request.size())),
+              static_cast<int>(request.size()));
+
+    // The server ends the connection after the response
+    std::string response;
+    std::array<char, 1024> buffer;
+    int bytes;
+    while ((bytes = BIO_read(bio, buffer.data(), static_cast<int>(buffer.size()))) > 0)
+        response.append(buffer.data(), static_cast<size_t>(bytes));
+
+    SSL* ssl = nullptr;
+    BIO_get_ssl(bio, &ssl);
+    ASSERT_NE(ssl, nullptr);
+    const bool closeNotifyReceived = (SSL_get_shutdown(ssl) & SSL_RECEIVED_SHUTDOWN) != 0;
+
+    BIO_free_all(bio);
+    SSL_CTX_free(ctx);
+    server.shutdown();
+
+    ASSERT_NE(response.find("Hello, World!"), std::string::npos);
+    ASSERT_TRUE(closeNotifyReceived);
+}
+
 // MUST be LAST test
 TEST(https_server_test, last_curl_global_cleanup)
 {
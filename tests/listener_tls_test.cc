@@ -9,7 +9,9 @@
 #include <pistache/listener.h>
 
 #include <chrono>
+#include <string>
 #include <openssl/bio.h>
+#include <openssl/ssl.h>
 #include <pistache/http.h>
 
 using testing::Eq;
@@ -100,3 +102,46 @@ TEST(listener_tls_test, tls_handshake_timeout_custom)
 
     BIO_free_all(bio);
 }
+
+TEST(listener_tls_test, tls_handshake_does_not_block_accept)
+{
+    Pistache::Tcp::Listener listener;
+    listener.init(1);
+    listener.setupSSL("./certs/server.crt", "./certs/server.key", false, nullptr);
+    listener.setHandler(Pistache::Http::make_handler<HelloHandler>());
+    listener.bind(Pistache::Address(Pistache::IP::loopback(), 0));
+    listener.runThreaded();
+
+    const std::string port = listener.getPort().toString();
+
+    // A client that connects but never starts its handshake
+    BIO* idle = BIO_new_connect("localhost");
+    BIO_set_conn_port(idle, port.c_str());
+    ASSERT_THAT(BIO_do_connect(idle), Eq(1));
+
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    BIO* bio     = BIO_new_ssl_connect(ctx);
+    BIO_set_conn_hostname(bio, "localhost");
+    BIO_set_conn_port(bio, port.c_str());
+
+    const auto pre_handshake = std::chrono::steady_clock::now();
+
+    // The handshake of a second client must not wait for the first one to
+    // time out
+    EXPECT_THAT(BIO_do_handshake(bio), Eq(1));
+
+    const auto duration = std::chrono::steady_clock::now() - pre_handshake;
+    EXPECT_THAT(duration, Le(std::chrono::seconds(5)));
+
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    EXPECT_THAT(BIO_write(bio, request.data(), static_cast<int>(request.size())),
+                Eq(static_cast<int>(request.size())));
+
+    char response[64] = {};
+    EXPECT_THAT(BIO_read(bio, response, sizeof(response) - 1), testing::Gt(0));
+    EXPECT_THAT(std::string(response), testing::StartsWith("HTTP/1.1 200 OK"));
+
+    BIO_free_all(bio);
+    SSL_CTX_free(ctx);
+    BIO_free_all(idle);
+}
@@ -10,6 +10,7 @@
 #include <pistache/winornix.h>
 
 #include <pistache/net.h>
+#include <pistache/resolver.h>
 
 #include <iostream>
 #include <stdexcept>
@@ -243,3 +244,44 @@ TEST(net_test, ip_creation)
     IP ip_unix(reinterpret_cast<struct sockaddr*>(&unix_socket));
     EXPECT_THAT(ip_unix.getFamily(), Eq(AF_UNIX));
 }
+
+TEST(net_test, reverse_resolver_caches_names)
+{
+    auto& resolver = ReverseResolver::instance();
+    resolver.clear();
+
+    const Address loopback(Ipv4::loopback(), Port(0));
+    EXPECT_FALSE(resolver.cached(loopback).has_value());
+
+    std::string name;
+    auto promise = resolver.resolve(loopback);
+    promise.then([&](const std::string& resolved) { name = resolved; }, Async::NoExcept);
+
+    Async::Barrier<std::string> barrier(promise);
+    ASSERT_EQ(barrier.wait_for(std::chrono::seconds(10)), std::cv_status::no_timeout);
+
+    // The name, or the lack of one, is now served from the cache
+    auto cached = resolver.cached(loopback);
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(*cached, name);
+    EXPECT_EQ(resolver.resolveNow(loopback), name);
+    EXPECT_EQ(resolver.size(), 1u);
+
+    // Unix domain peers are local, and never looked up
+    struct sockaddr_un unix_socket = {};
+    unix_socket.sun_family         = AF_UNIX;
+    const auto local = Address::fromUnix(reinterpret_cast<struct sockaddr*>(&unix_socket));
+    EXPECT_EQ(resolver.resolveNow(local), "localhost");
+    EXPECT_EQ(resolver.size(), 1u);
+
+    resolver.maxEntries(0);
+    EXPECT_EQ(resolver.size(), 0u);
+    EXPECT_FALSE(resolver.cached(loopback).has_value());
+    resolver.maxEntries(ReverseResolver::DefaultMaxEntries);
+
+    // Past the pending cap, lookups fail rather than queue up
+    resolver.maxPending(0);
+    auto refused = resolver.resolve(loopback);
+    EXPECT_TRUE(refused.isRejected());
+    resolver.maxPending(ReverseResolver::DefaultMaxPending);
+}
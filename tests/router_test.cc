@@ -11,6 +11,7 @@
 */
 
 #include <algorithm>
+#include <optional>
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
@@ -171,6 +172,62 @@ TEST(router_test, test_mixed)
     ASSERT_TRUE(matchSplat(routes, "/hi", { "hi" }));
 }
 
+TEST(router_test, test_match_route_unsanitized)
+{
+    SegmentTreeNode routes;
+    const auto s = SegmentTreeNode::sanitizeResource("/v1/hello/:name/");
+    const auto p = SegmentTreeNode::sanitizeResource("/say/*/to/*");
+    const auto o = SegmentTreeNode::sanitizeResource("/get/:key?/bar");
+    routes.addRoute(std::string_view { s.data(), s.length() }, nullptr, nullptr);
+    routes.addRoute(std::string_view { p.data(), p.length() }, nullptr, nullptr);
+    routes.addRoute(std::string_view { o.data(), o.length() }, nullptr, nullptr);
+
+    RouteMatch match;
+    ASSERT_NE(routes.matchRoute("//v1///hello/joe//", match), nullptr);
+    ASSERT_EQ(match.size(), 1u);
+    ASSERT_EQ(match.begin()->name, ":name");
+    ASSERT_EQ(match.begin()->value, "joe");
+
+    match.clear();
+    ASSERT_NE(routes.matchRoute("/say/hello/to/user/", match), nullptr);
+    const auto splats = match.splats();
+    ASSERT_EQ(splats.size(), 2u);
+    ASSERT_EQ(splats[0].as<std::string>(), "hello");
+    ASSERT_EQ(splats[1].as<std::string>(), "user");
+    ASSERT_TRUE(match.params().empty());
+
+    match.clear();
+    ASSERT_NE(routes.matchRoute("/get/foo//bar", match), nullptr);
+    const auto params = match.params();
+    ASSERT_EQ(params.size(), 1u);
+    ASSERT_EQ(params[0].name(), ":key");
+    ASSERT_EQ(params[0].as<std::string>(), "foo");
+
+    match.clear();
+    ASSERT_EQ(routes.matchRoute("/say/hello/to", match), nullptr);
+    ASSERT_FALSE(match.overflowed());
+}
+
+TEST(router_test, test_match_route_overflow)
+{
+    std::string resource;
+    std::string request;
+    for (size_t i = 0; i <= RouteMatch::MaxEntries; ++i)
+    {
+        resource += "/:p" + std::to_string(i);
+        request += "/v" + std::to_string(i);
+    }
+
+    SegmentTreeNode routes;
+    auto s = SegmentTreeNode::sanitizeResource(resource);
+    routes.addRoute(std::string_view { s.data(), s.length() }, nullptr, nullptr);
+
+    RouteMatch match;
+    ASSERT_EQ(routes.matchRoute(request, match), nullptr);
+    ASSERT_TRUE(match.overflowed());
+    ASSERT_TRUE(matchParams(routes, request, { { ":p0", "v0" }, { ":p16", "v16" } }));
+}
+
 TEST(router_test, test_notfound_exactly_once)
 {
     Address addr(Ipv4::any(), 0);
@@ -224,6 +281,123 @@ TEST(router_test, test_notfound_exactly_once)
     endpoint->shutdown();
 }
 
+TEST(router_test, test_params_survive_request_copies)
+{
+    Address addr(Ipv4::any(), 0);
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+
+    auto opts = Http::Endpoint::options().threads(1).maxRequestSize(4096);
+    endpoint->init(opts);
+
+    std::string id;
+    std::string splat;
+
+    Rest::Router router;
+    Routes::Get(router, "/u/:id/*",
+                [&](const Pistache::Rest::Request& request,
+                    Pistache::Http::ResponseWriter response) {
+                    // The parameters are offsets into the resource, which a
+                    // short resource keeps inline and so moves along
+                    auto copy  = request;
+                    auto moved = std::move(copy);
+                    copy       = moved;
+                    moved      = std::move(copy);
+
+                    id    = moved.param(":id").as<std::string>();
+                    splat = moved.splatAt(0).as<std::string>();
+                    response.send(Pistache::Http::Code::Ok);
+                    return Pistache::Rest::Route::Result::Ok;
+                });
+
+    endpoint->setHandler(router.handler());
+    endpoint->serveThreaded();
+    httplib::Client client("localhost", endpoint->getPort());
+
+    client.Get("/u/ab/cd");
+    ASSERT_EQ(id, "ab");
+    ASSERT_EQ(splat, "cd");
+
+    endpoint->shutdown();
+}
+
+TEST(router_test, test_params_outlive_router)
+{
+    std::optional<Rest::Request> kept;
+
+    {
+        Address addr(Ipv4::any(), 0);
+        auto endpoint = std::make_shared<Http::Endpoint>(addr);
+
+        auto opts = Http::Endpoint::options().threads(1).maxRequestSize(4096);
+        endpoint->init(opts);
+
+        Rest::Router router;
+        Routes::Get(router, "/u/:id/*",
+                    [&](const Pistache::Rest::Request& request,
+                        Pistache::Http::ResponseWriter response) {
+                        kept.emplace(request);
+                        response.send(Pistache::Http::Code::Ok);
+                        return Pistache::Rest::Route::Result::Ok;
+                    });
+
+        endpoint->setHandler(router.handler());
+        endpoint->serveThreaded();
+        httplib::Client client("localhost", endpoint->getPort());
+
+        client.Get("/u/ab/cd");
+        endpoint->shutdown();
+    }
+
+    // The router, and with it the names of the parameters in its route
+    // tree, are gone
+    ASSERT_TRUE(kept.has_value());
+    ASSERT_TRUE(kept->hasParam(":id"));
+    ASSERT_EQ(kept->param(":id").name(), ":id");
+    ASSERT_EQ(kept->param(":id").as<std::string>(), "ab");
+    ASSERT_EQ(kept->splatAt(0).as<std::string>(), "cd");
+}
+
+TEST(router_test, test_many_params_are_kept_out_of_line)
+{
+    Address addr(Ipv4::any(), 0);
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+
+    auto opts = Http::Endpoint::options().threads(1).maxRequestSize(4096);
+    endpoint->init(opts);
+
+    std::string resource;
+    std::string path;
+    for (size_t i = 0; i <= Rest::Request::InlineEntries; ++i)
+    {
+        resource += "/:p" + std::to_string(i);
+        path += "/v" + std::to_string(i);
+    }
+
+    std::vector<std::string> values;
+
+    Rest::Router router;
+    Routes::Get(router, resource,
+                [&](const Pistache::Rest::Request& request,
+                    Pistache::Http::ResponseWriter response) {
+                    auto copy = request;
+                    for (size_t i = 0; i <= Rest::Request::InlineEntries; ++i)
+                        values.push_back(copy.param(":p" + std::to_string(i)).as<std::string>());
+                    response.send(Pistache::Http::Code::Ok);
+                    return Pistache::Rest::Route::Result::Ok;
+                });
+
+    endpoint->setHandler(router.handler());
+    endpoint->serveThreaded();
+    httplib::Client client("localhost", endpoint->getPort());
+
+    client.Get(path);
+    ASSERT_EQ(values.size(), Rest::Request::InlineEntries + 1);
+    ASSERT_EQ(values.front(), "v0");
+    ASSERT_EQ(values.back(), "v" + std::to_string(Rest::Request::InlineEntries));
+
+    endpoint->shutdown();
+}
+
 TEST(router_test, test_route_head_request)
 {
     Address addr(Ipv4::any(), 0);
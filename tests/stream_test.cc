@@ -8,13 +8,17 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <climits>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #ifdef _IS_WINDOWS
 #include <Windows.h>
@@ -134,6 +138,124 @@ TEST(stream, test_array_buffer)
     ASSERT_FALSE(buffer.feed(part2, strlen(part2)));
 }
 
+TEST(stream, test_array_buffer_prepare_commit)
+{
+    ArrayStreamBuf<char> buffer(Const::MaxBuffer * 2);
+    StreamCursor cursor { &buffer };
+
+    // Bytes written in place only become readable once committed
+    size_t len = 4;
+    char* dest = buffer.prepare(len);
+    ASSERT_EQ(len, 4u);
+    std::memcpy(dest, "abcd", 4);
+    ASSERT_EQ(cursor.remaining(), 0u);
+
+    buffer.commit(4);
+    ASSERT_EQ(cursor.remaining(), 4u);
+    ASSERT_TRUE(cursor.advance(2));
+
+    // Asking for more than what is left of the block only gets that much
+    len  = Const::MaxBuffer;
+    dest = buffer.prepare(len);
+    ASSERT_EQ(len, BufferPool::MinBlockSize - 4);
+    std::memset(dest, 'x', len);
+    buffer.commit(len);
+
+    // A full block grows, up to maxSize, and keeps the read position
+    len  = Const::MaxBuffer * 4;
+    dest = buffer.prepare(len);
+    ASSERT_EQ(len, Const::MaxBuffer * 2 - BufferPool::MinBlockSize);
+    ASSERT_EQ(cursor.current(), 'c');
+
+    std::memset(dest, 'y', len);
+    buffer.commit(len);
+    ASSERT_EQ(buffer.room(), 0u);
+
+    len = 1;
+    buffer.prepare(len);
+    ASSERT_EQ(len, 0u);
+}
+
+TEST(stream, test_array_buffer_compact)
+{
+    ArrayStreamBuf<char> buffer(8);
+    StreamCursor cursor { &buffer };
+
+    ASSERT_TRUE(buffer.feed("abcdef", 6));
+    ASSERT_FALSE(buffer.feed("ghi", 3));
+
+    // Only the unread bytes are kept, making room for more
+    cursor.advance(4);
+    buffer.compact();
+    ASSERT_EQ(cursor.remaining(), 2u);
+    ASSERT_EQ(cursor.current(), 'e');
+    ASSERT_TRUE(buffer.feed("ghi", 3));
+    ASSERT_EQ(std::string(cursor.offset(), cursor.remaining()), "efghi");
+
+    // Once everything has been read, the memory goes back to the pool
+    const size_t cached = BufferPool::cached();
+    cursor.advance(5);
+    buffer.compact();
+    ASSERT_EQ(cursor.remaining(), 0u);
+    ASSERT_EQ(BufferPool::cached(), cached + 1);
+
+    // And is taken from there again
+    ASSERT_TRUE(buffer.feed("jk", 2));
+    ASSERT_EQ(BufferPool::cached(), cached);
+    ASSERT_EQ(cursor.current(), 'j');
+}
+
+TEST(stream, test_array_buffer_compact_part_of_what_was_read)
+{
+    ArrayStreamBuf<char> buffer(8);
+    StreamCursor cursor { &buffer };
+
+    ASSERT_TRUE(buffer.feed("abcdefgh", 8));
+    cursor.advance(5);
+
+    // The read position stays on the same byte
+    buffer.compact(3);
+    ASSERT_EQ(buffer.position(), 2u);
+    ASSERT_EQ(cursor.current(), 'f');
+    ASSERT_EQ(buffer.room(), 3u);
+
+    // No more than what was read is dropped
+    buffer.compact(4);
+    ASSERT_EQ(buffer.position(), 0u);
+    ASSERT_EQ(std::string(cursor.offset(), cursor.remaining()), "fgh");
+}
+
+TEST(stream, test_array_buffer_copy_and_move)
+{
+    ArrayStreamBuf<char> buffer(8);
+    StreamCursor cursor { &buffer };
+
+    ASSERT_TRUE(buffer.feed("abcdefgh", 8));
+    cursor.advance(3);
+
+    // A copy has bytes of its own, read from the same position
+    ArrayStreamBuf<char> copy(buffer);
+    StreamCursor copyCursor { &copy };
+    ASSERT_NE(copy.begptr(), buffer.begptr());
+    ASSERT_EQ(std::string(copyCursor.offset(), copyCursor.remaining()), "defgh");
+    ASSERT_EQ(copy.room(), 0u);
+
+    ArrayStreamBuf<char> moved(std::move(copy));
+    StreamCursor movedCursor { &moved };
+    ASSERT_EQ(std::string(movedCursor.offset(), movedCursor.remaining()), "defgh");
+    ASSERT_EQ(copy.position(), 0u);
+    ASSERT_EQ(copy.room(), 8u);
+
+    ArrayStreamBuf<char> assigned(4);
+    ASSERT_TRUE(assigned.feed("xyz", 3));
+    assigned = buffer;
+    StreamCursor assignedCursor { &assigned };
+    ASSERT_EQ(std::string(assignedCursor.offset(), assignedCursor.remaining()), "defgh");
+
+    // The original is left as it was
+    ASSERT_EQ(std::string(cursor.offset(), cursor.remaining()), "defgh");
+}
+
 TEST(stream, test_cursor_advance_for_array)
 {
     ArrayStreamBuf<char> buffer(Const::MaxBuffer);
@@ -237,3 +359,35 @@ TEST(stream, test_cursor_diff_for_array)
     second_cursor.advance(4);
     ASSERT_EQ(second_cursor.diff(first_cursor), 0u);
 }
+
+TEST(stream, test_find_any_of)
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    const std::vector<std::string_view> sets = { ":", " ?", "= &", "\r\n", "abcdefghij", "0123456789abcdefXYZ" };
+
+    for (size_t len = 0; len < 130; ++len)
+    {
+        std::string data(len + 7, '\0');
+        for (auto& c : data)
+            c = static_cast<char>(byte(rng));
+
+        // Unaligned starting offsets exercise the vector loads and the tail
+        for (size_t offset = 0; offset < 7; ++offset)
+        {
+            const char* begin = data.data() + offset;
+            const char* end   = begin + len;
+            for (auto set : sets)
+            {
+                const char* expected = std::find_first_of(begin, end, set.begin(), set.end());
+                ASSERT_EQ(find_any_of(begin, end, set), expected);
+            }
+        }
+    }
+
+    const std::string line = "GET /path/to/some/resource/that/is/rather/long?key=value HTTP/1.1";
+    ASSERT_EQ(find_any_of(line.data(), line.data() + line.size(), "?") - line.data(), 46);
+    ASSERT_EQ(find_any_of(line.data(), line.data() + line.size(), "=&") - line.data(), 50);
+    ASSERT_EQ(find_any_of(line.data(), line.data() + line.size(), "#!"), line.data() + line.size());
+}
@@ -288,6 +288,55 @@ TEST_F(StreamingTests, ChunkedStream)
 
 }
 
+class ManyChunksHandler : public Http::Handler
+{
+public:
+    HTTP_PROTOTYPE(ManyChunksHandler)
+
+    static constexpr size_t N_CHUNKS = 5000;
+
+    static std::string chunk(size_t i)
+    {
+        return std::to_string(i) + std::string(i % 97, 'x') + "\n";
+    }
+
+    void onRequest(const Http::Request&, Http::ResponseWriter response) override
+    {
+        PS_TIMEDBG_START_THIS;
+
+        // Every flush queues a separate write, so the writes pile up for
+        // the peer and go out together
+        auto stream = response.stream(Http::Code::Ok);
+        for (size_t i = 0; i < N_CHUNKS; ++i)
+        {
+            stream << chunk(i).c_str();
+            stream.flush();
+        }
+        stream.ends();
+    }
+};
+
+TEST_F(StreamingTests, ManySmallChunks)
+{
+    PS_TIMEDBG_START;
+
+    { // encapsulate
+
+    Init(std::make_shared<ManyChunksHandler>());
+
+    CURLcode res = curl_easy_perform(curl);
+    ASSERT_EQ(res, CURLE_OK);
+
+    std::string expected;
+    for (size_t i = 0; i < ManyChunksHandler::N_CHUNKS; ++i)
+        expected += ManyChunksHandler::chunk(i);
+
+    ASSERT_EQ(chunksToString(chunks), expected);
+
+    } // end encapsulate
+
+}
+
 class ClientDisconnectHandler : public Http::Handler
 {
 public:
@@ -0,0 +1,112 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/timer_wheel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace Pistache;
+using namespace std::chrono_literals;
+
+using Wheel = TimerWheel<int>;
+
+TEST(timer_wheel_test, expires_keys_at_their_deadline)
+{
+    const auto start = Wheel::Clock::now();
+    Wheel wheel(10ms, start);
+
+    wheel.schedule(1, start + 25ms);
+    wheel.schedule(2, start + 5ms);
+    wheel.schedule(3, start + 10s);
+    ASSERT_EQ(wheel.size(), 3u);
+
+    std::vector<int> expired;
+    wheel.advance(start + 10ms, expired);
+    ASSERT_EQ(expired, std::vector<int>({ 2 }));
+
+    expired.clear();
+    wheel.advance(start + 20ms, expired);
+    ASSERT_TRUE(expired.empty());
+
+    wheel.advance(start + 30ms, expired);
+    ASSERT_EQ(expired, std::vector<int>({ 1 }));
+
+    // Goes through the coarser levels before expiring
+    expired.clear();
+    wheel.advance(start + 9990ms, expired);
+    ASSERT_TRUE(expired.empty());
+    wheel.advance(start + 10s, expired);
+    ASSERT_EQ(expired, std::vector<int>({ 3 }));
+    ASSERT_TRUE(wheel.empty());
+}
+
+TEST(timer_wheel_test, reschedules_and_cancels)
+{
+    const auto start = Wheel::Clock::now();
+    Wheel wheel(10ms, start);
+
+    wheel.schedule(1, start + 50ms);
+    wheel.schedule(2, start + 50ms);
+    wheel.schedule(3, start + 50ms);
+
+    wheel.schedule(1, start + 2s); // pushed back
+    wheel.schedule(2, start + 20ms); // brought forward
+    wheel.cancel(3);
+    ASSERT_FALSE(wheel.contains(3));
+
+    std::vector<int> expired;
+    wheel.advance(start + 20ms, expired);
+    ASSERT_EQ(expired, std::vector<int>({ 2 }));
+
+    expired.clear();
+    wheel.advance(start + 1990ms, expired);
+    ASSERT_TRUE(expired.empty());
+    wheel.advance(start + 2s, expired);
+    ASSERT_EQ(expired, std::vector<int>({ 1 }));
+}
+
+TEST(timer_wheel_test, past_deadline_expires_on_next_tick)
+{
+    const auto start = Wheel::Clock::now();
+    Wheel wheel(10ms, start);
+
+    std::vector<int> expired;
+    wheel.advance(start + 100ms, expired);
+
+    wheel.schedule(1, start);
+    wheel.advance(start + 100ms, expired);
+    ASSERT_TRUE(expired.empty());
+    wheel.advance(start + 110ms, expired);
+    ASSERT_EQ(expired, std::vector<int>({ 1 }));
+}
+
+TEST(timer_wheel_test, many_keys_over_all_levels)
+{
+    const auto start = Wheel::Clock::now();
+    Wheel wheel(1ms, start);
+
+    // Deadlines spread over the four levels, and beyond them
+    const std::vector<int> offsets = { 1, 63, 64, 65, 4095, 4096, 4097,
+                                       262143, 262144, 300000, 16777215,
+                                       16777216, 20000000 };
+    for (size_t i = 0; i < offsets.size(); ++i)
+        wheel.schedule(static_cast<int>(i), start + std::chrono::milliseconds(offsets[i]));
+
+    for (size_t i = 0; i < offsets.size(); ++i)
+    {
+        std::vector<int> expired;
+        wheel.advance(start + std::chrono::milliseconds(offsets[i] - 1), expired);
+        ASSERT_TRUE(expired.empty()) << "offset " << offsets[i];
+
+        wheel.advance(start + std::chrono::milliseconds(offsets[i]), expired);
+        ASSERT_EQ(expired, std::vector<int>({ static_cast<int>(i) })) << "offset " << offsets[i];
+    }
+    ASSERT_TRUE(wheel.empty());
+}